@@ -0,0 +1,110 @@
+#!/bin/sh
+# gen_stress.sh
+# Copyright (C) 2013 Takeutch Kemeco
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+# コンパイラーの各テーブルの容量を試すための、大きなソースファイルを生成する。
+#
+# 使い方:
+#     sh gen_stress.sh [出力ディレクトリ名 [行数]]
+#     cd 出力ディレクトリ名 && onbc --time-report stress.nb
+#
+# 出力ディレクトリ（既定は stress）へ stress.nb と、それが入れ子に #include する stress_inc*.nb を生成する。
+# 行数の既定は 200000 。生成されるソースには以下が含まれる:
+#   ・グローバル変数、識別子、ラベルを 0x1000 個以上
+#   ・ローカル変数を 0x1000 個以上持つ関数と、0x1000 段以上入れ子にしたブロック
+#   ・メンバーを 0x1000 個以上持つ構造体
+#   ・16 段を越える #include の入れ子
+#   ・#define を 0x1000 個以上
+# 残りの行は、グローバル変数への代入文で埋める。
+
+dir=${1:-stress}
+lines=${2:-200000}
+
+# 各要素の個数（何れも以前の固定長テーブルの上限 0x1000 を越える数）
+n_global=8192
+n_local=8192
+n_scope=5000
+n_member=8192
+n_define=8192
+n_label=8192
+n_include=64
+
+mkdir -p "$dir" || exit 1
+
+# #include の入れ子
+i=0
+while [ $i -lt $n_include ]; do
+        next=$((i + 1))
+        {
+                echo "float inc$i = $i;"
+                if [ $next -lt $n_include ]; then
+                        echo "#include \"stress_inc$next.nb\""
+                fi
+        } > "$dir/stress_inc$i.nb"
+        i=$next
+done
+
+awk -v lines="$lines" \
+    -v n_global="$n_global" -v n_local="$n_local" -v n_scope="$n_scope" \
+    -v n_member="$n_member" -v n_define="$n_define" -v n_label="$n_label" '
+function out(s) {
+        print s
+        n++
+}
+
+BEGIN {
+        n = 0
+
+        out("#include \"stress_inc0.nb\"")
+
+        for (i = 0; i < n_define; i++)
+                out("#define DEF" i " " i)
+
+        out("struct S {")
+        for (i = 0; i < n_member; i++)
+                out("        float m" i ";")
+        out("};")
+
+        for (i = 0; i < n_global; i++)
+                out("float g" i " = DEF" (i % n_define) ";")
+
+        out("function f(x)")
+        out("{")
+        for (i = 0; i < n_local; i++)
+                out("        float l" i " = x;")
+        out("        return l" (n_local - 1) ";")
+        out("}")
+
+        out("function h(x)")
+        out("{")
+        for (i = 0; i < n_scope; i++)
+                out("{")
+        out("        float y = x;")
+        for (i = 0; i < n_scope; i++)
+                out("}")
+        out("        return x;")
+        out("}")
+
+        for (i = 0; i < n_label; i++) {
+                out("label" i ":")
+                out("        g" (i % n_global) " = f(" i ");")
+        }
+        out("        goto label0;")
+
+        for (i = 0; n < lines; i++)
+                out("g" (i % n_global) " = g" ((i + 1) % n_global) " + h(" i ");")
+}' > "$dir/stress.nb"
@@ -21,16 +21,33 @@
 #include <string.h>
 #include <stdint.h>
 #include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
 #include "config.h"
+#include "onbc.context.h"
+#include "onbc.cache.h"
+#include "onbc.report.h"
+#include "onbc.file.h"
+#include "onbc.label.h"
+#include "onbc.program.h"
 
-extern FILE* yyin;
-extern FILE* yyout;
-extern FILE* yyaskA;
-extern FILE* yyaskB;
+extern __thread FILE* yyaskA;
+extern __thread FILE* yyaskB;
+
+void start_main_process(struct SourceFile* file);
+void start_tune_process(char* src, const size_t len);
+void end_tune_process(void);
+void lex_process(void);
 
 static void print_usage(void)
 {
-        printf("使用法: %s 入力ファイル.nb [出力ファイル.ask]\n"
+        printf("使用法: %s 入力ファイル.nb [出力ファイル.ask]  （ファイル名に - を指定すると標準入出力）\n"
+               "       %s [-j 並列数] 入力ファイル1.nb 入力ファイル2.nb ...\n"
+               "\n"
+               "  -j N               N 個のスレッドで並列にコンパイルする\n"
+               "  --cache-dir=DIR    コンパイル結果を DIR にキャッシュする（環境変数 ONBC_CACHE_DIR でも指定可）\n"
+               "  --time-report      工程ごとの経過時間、CPU時間、最大RSS、各種カウンターを表示する\n"
+               "  --whole-program    プログラム全体の EC 木を保持し、解析パスを実行してから翻訳する\n"
                "\n"
                "%s version %s\n"
                "Copyright(C) 2013 Takeutch Kemeco\n"
@@ -43,7 +60,7 @@ static void print_usage(void)
                "\n"
                "repository: <https://github.com/takeutch-kemeco/osecpu-basic>\n"
                "bug report: <%s>\n",
-               "onbc",
+               "onbc", "onbc",
                PACKAGE_NAME, VERSION,
                PACKAGE_BUGREPORT);
 }
@@ -54,60 +71,84 @@ static void print_file_open_err(const char* s)
         exit(EXIT_FAILURE);
 }
 
-static FILE* open_in_file(const char* in_path)
+/* 入力ファイルを読み込む。 in_path が "-" の場合は標準入力を用いる。
+ */
+static struct SourceFile* open_in_file(const char* in_path)
 {
-        FILE* fp = fopen(in_path, "rt");
-        if (fp == NULL)
+        struct SourceFile* file = source_file_load(in_path);
+        if (file == NULL)
                 print_file_open_err(in_path);
 
-        return fp;
+        return file;
 }
 
-static FILE* open_null_out_file(void)
+/* 出力ファイルを開く。 out_path が "-" の場合は標準出力を用いる。
+ */
+static FILE* open_out_file(const char* out_path)
 {
-        FILE* fp = fopen("/dev/null", "w");
+        if (strcmp(out_path, "-") == 0)
+                return stdout;
+
+        FILE* fp = fopen(out_path, "wt");
         if (fp == NULL)
-                print_file_open_err("/dev/null");
+                print_file_open_err(out_path);
 
         return fp;
 }
 
-static FILE* open_out_file(const char* out_path)
+/* open_out_file() で開いたファイルを閉じる。
+ * 標準出力は閉じずに、フラッシュのみ行う。
+ */
+static void close_file(FILE* fp)
 {
-        FILE* fp = fopen(out_path, "wt");
-        if (fp == NULL)
-                print_file_open_err(out_path);
+        if (fp == stdout)
+                fflush(fp);
+        else
+                fclose(fp);
+}
+
+/* 可変長のメモリー上のバッファーへ書き出すストリームを開く。
+ * fclose() した時点で *buf, *len に内容と長さがセットされる。（*buf は呼出側で free() すること）
+ */
+static FILE* open_mem_out_file(char** buf, size_t* len)
+{
+        FILE* fp = open_memstream(buf, len);
+        if (fp == NULL) {
+                printf("system err: open_memstream() に失敗しました\n");
+                exit(EXIT_FAILURE);
+        }
 
         return fp;
 }
 
-static void marge_file(const char* out_path,
-                       const char* in_path_a,
-                       const char* in_path_b)
+/* header -> a -> b の順で連結した、新たなバッファーを返す。
+ * 連結後の長さ（終端分は含まない）が *len にセットされる。
+ *
+ * 末尾には '\0' を2つ付加する。
+ * これは flex の yy_scan_buffer() で、コピー無しで直接字句解析できるようにするため。
+ */
+static char* marge_buffer(size_t* len,
+                          const char* header,
+                          const char* a, const size_t a_len,
+                          const char* b, const size_t b_len)
 {
-        FILE* out = open_out_file(out_path);
-        FILE* in_a = open_in_file(in_path_a);
-        FILE* in_b = open_in_file(in_path_b);
-
-        while (1) {
-                int c = fgetc(in_a);
-                if (c == EOF)
-                        break;
+        const size_t header_len = strlen(header);
 
-                fputc(c, out);
+        char* buf = malloc(header_len + a_len + b_len + 2);
+        if (buf == NULL) {
+                printf("system err: marge_buffer(), malloc()\n");
+                exit(EXIT_FAILURE);
         }
 
-        while (1) {
-                int c = fgetc(in_b);
-                if (c == EOF)
-                        break;
+        memcpy(buf, header, header_len);
+        memcpy(buf + header_len, a, a_len);
+        memcpy(buf + header_len + a_len, b, b_len);
 
-                fputc(c, out);
-        }
+        *len = header_len + a_len + b_len;
+        buf[*len] = '\0';
+        buf[*len + 1] = '\0';
 
-        fclose(out);
-        fclose(in_a);
-        fclose(in_b);
+        return buf;
 }
 
 static int path_to_filename(char* dst, char* src)
@@ -123,71 +164,270 @@ static int path_to_filename(char* dst, char* src)
         strcpy(dst, head);
 }
 
-static int swap_filename_extention_nb_to_ask(char* a)
+/* ファイル名の拡張子が .nb であれば 1 、それ以外であれば 0 を返す
+ */
+static int is_filename_extention_nb(const char* a)
 {
         size_t len = strlen(a);
-        if (strcmp(a + len - 3, ".nb") != 0) {
+        if (len < 3)
+                return 0;
+
+        return strcmp(a + len - 3, ".nb") == 0;
+}
+
+static int swap_filename_extention_nb_to_ask(char* a)
+{
+        if (!is_filename_extention_nb(a)) {
                 printf("file err: 読み込もうとしてるソースファイルの拡張子が .nb ではありません\n");
                 exit(EXIT_FAILURE);
         }
 
+        size_t len = strlen(a);
         strcpy(a + len - 3, ".ask");
 }
 
-int main(int argc, char** argv)
+/* 1つの翻訳単位 ctx->in_path をコンパイルして、ctx->out_path へ書き出す
+ * 翻訳単位の状態は全てスレッド毎に保持されるので、別々のスレッドから同時に呼び出せる。
+ */
+static void compile(struct Context* ctx)
 {
-        char* in_path = argv[1];
-        char out_path[0x1000];
+        /* yyaskA, yyaskB の内容は一時ファイルを経由せずに、メモリー上に保持する */
+        struct SourceFile* in = open_in_file(ctx->in_path);
+        yyaskA = open_mem_out_file(&ctx->buf_a, &ctx->len_a);
+        yyaskB = open_mem_out_file(&ctx->buf_b, &ctx->len_b);
+
+        report_begin(REPORT_PHASE_MAIN_PROCESS);
+        init_all();
+        start_main_process(in);
+        yyparse();
+        report_end(REPORT_PHASE_MAIN_PROCESS);
 
-        switch (argc) {
-        case 2:
-                path_to_filename(out_path, in_path);
-                swap_filename_extention_nb_to_ask(out_path);
-                break;
+        fclose(yyaskA);
+        fclose(yyaskB);
 
-        case 3:
-                strcpy(out_path, argv[2]);
-                break;
+        /* ヘッダー -> yyaskB -> yyaskA の順でバッファーをマージする
+         * LOCALLABELS() には、この翻訳単位で実際に使用したラベル数を指定する。
+         */
+        report_begin(REPORT_PHASE_MARGE);
+        char header[0x100];
+        sprintf(header,
+                "#include \"osecpu_ask.h\"\n\n"
+                "LOCALLABELS(%d);\n\n",
+                (cur_label_index_head > 0) ? cur_label_index_head : 1);
 
-        default:
-                print_usage();
+        size_t len = 0;
+        char* buf = marge_buffer(&len, header, ctx->buf_b, ctx->len_b, ctx->buf_a, ctx->len_a);
+        report_end(REPORT_PHASE_MARGE);
+
+        FILE* out = open_out_file(ctx->out_path);
+
+        report_begin(REPORT_PHASE_TUNE_PROCESS);
+#ifndef DISABLE_TUNE
+        yyaskB = out;
+
+        start_tune_process(buf, len + 2);
+        lex_process();
+        end_tune_process();
+#else
+        fwrite(buf, 1, len, out);
+#endif /* DISABLE_TUNE */
+        report_end(REPORT_PHASE_TUNE_PROCESS);
+
+        close_file(out);
+        free(buf);
+
+        report_print(ctx->in_path);
+}
+
+/* in_path に対応する出力ファイル名を out_path にセットする。
+ * 出力ファイルはカレントディレクトリーに、拡張子を .ask に変えた名前で作られる。
+ */
+static void in_path_to_out_path(char* out_path, char* in_path)
+{
+        path_to_filename(out_path, in_path);
+        swap_filename_extention_nb_to_ask(out_path);
+}
+
+/* in_path をコンパイルして out_path へ書き出す
+ * キャッシュが有効であれば、同じ内容のコンパイル結果がキャッシュに有る場合はそれを用い、
+ * 無ければコンパイル後にキャッシュへ保存する。
+ */
+static void compile_cached(char* in_path, char* out_path)
+{
+        char key[CACHE_KEY_LEN];
+        const int32_t use_cache = (cache_key(key, in_path, out_path) == 0);
+
+        if (use_cache && cache_fetch(key, out_path) == 0)
+                return;
+
+        struct Context* ctx = new_context(in_path, out_path);
+        compile(ctx);
+        delete_context(ctx);
+
+        if (use_cache)
+                cache_store(key, out_path);
+}
+
+/* 入力ファイル in_path をコンパイルし、カレントディレクトリーの .ask へ書き出す
+ * in_path が "-" の場合は、標準入力からの入力をコンパイルして標準出力へ書き出す。
+ */
+static void compile_file(char* in_path)
+{
+        /* 出力ファイル名は、入力ファイル名の拡張子 .nb を .ask に置き換えたもの */
+        char* out_path = malloc(strlen(in_path) + sizeof(".ask"));
+        if (out_path == NULL) {
+                printf("system err: compile_file(), malloc()\n");
                 exit(EXIT_FAILURE);
         }
 
-        yyin = open_in_file(in_path);
-        yyout = open_null_out_file();
-        yyaskA = open_out_file("onbc.tmp.0");
-        yyaskB = open_out_file("onbc.tmp.1");
+        if (strcmp(in_path, "-") == 0)
+                strcpy(out_path, "-");
+        else
+                in_path_to_out_path(out_path, in_path);
+
+        compile_cached(in_path, out_path);
+
+        free(out_path);
+}
+
+/* 並列コンパイル時のワーカースレッドのスタックサイズ
+ * スタックを深く使うのは、EC 木を再帰で辿る translate_ec(), fold_ec() などで、その深さは式やブロックの入れ子の深さとなる。
+ * （トップレベルの宣言と文のリストは要素を順に辿るので、ソースの長さには依らない）
+ * スレッドのデフォルトのスタックサイズは処理系によっては小さいので、深い入れ子の式でも足りるように明示的に指定する。
+ */
+#define WORKER_STACK_SIZE (16 * 1024 * 1024)
+
+/* 並列コンパイルの作業キュー
+ * 各ワーカースレッドは next を不可分にインクリメントして、未処理の入力ファイルを1つずつ取り出す。
+ * 翻訳単位ごとの処理時間がばらついても、空いたスレッドから順に次のファイルを取るので偏りは生じない。
+ */
+struct WorkQueue {
+        char** in_path;
+        int32_t in_path_len;
+        int32_t next;
+};
+
+static void* compile_worker(void* arg)
+{
+        struct WorkQueue* queue = arg;
+
+        while (1) {
+                const int32_t i = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED);
+                if (i >= queue->in_path_len)
+                        break;
 
-        start_pre_process(in_path);
-        while (yylex() != 0) {
+                compile_file(queue->in_path[i]);
         }
 
-        fseek(yyin, 0, SEEK_SET);
-        yyrestart(yyin);
+        return NULL;
+}
 
-        init_all();
-        start_main_process(in_path);
-        yyparse();
+/* in_path[] の各ファイルを jobs 個のスレッドで並列にコンパイルする
+ */
+static void compile_parallel(char** in_path, const int32_t in_path_len, int32_t jobs)
+{
+        if (jobs > in_path_len)
+                jobs = in_path_len;
+
+        struct WorkQueue queue = {
+                .in_path = in_path,
+                .in_path_len = in_path_len,
+                .next = 0,
+        };
+
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, WORKER_STACK_SIZE);
+
+        pthread_t* thread = malloc(sizeof(*thread) * jobs);
+        if (thread == NULL) {
+                printf("system err: compile_parallel(), malloc()\n");
+                exit(EXIT_FAILURE);
+        }
 
-        fclose(yyaskA);
-        fclose(yyaskB);
-        fclose(yyin);
+        int32_t i;
+        for (i = 0; i < jobs; i++) {
+                if (pthread_create(thread + i, &attr, compile_worker, &queue) != 0) {
+                        printf("system err: compile_parallel(), pthread_create()\n");
+                        exit(EXIT_FAILURE);
+                }
+        }
 
-        /* yyaskB -> yyaskA の順でファイルをマージする */
-        marge_file("onbc.tmp.2", "onbc.tmp.1", "onbc.tmp.0");
+        for (i = 0; i < jobs; i++)
+                pthread_join(thread[i], NULL);
 
-#ifndef DISABLE_TUNE
-        yyin = open_in_file("onbc.tmp.2");
-        yyaskB = open_out_file(out_path);
+        free(thread);
+        pthread_attr_destroy(&attr);
+}
+
+int main(int argc, char** argv)
+{
+        int32_t jobs = 1;
+        char* cache_dir = NULL;
+
+        static const struct option long_options[] = {
+                {"cache-dir", required_argument, NULL, 'C'},
+                {"time-report", no_argument, NULL, 'T'},
+                {"whole-program", no_argument, NULL, 'W'},
+                {NULL, 0, NULL, 0}
+        };
+
+        int opt;
+        while ((opt = getopt_long(argc, argv, "j:", long_options, NULL)) != -1) {
+                switch (opt) {
+                case 'j':
+                        jobs = atoi(optarg);
+                        if (jobs < 1) {
+                                print_usage();
+                                exit(EXIT_FAILURE);
+                        }
+                        break;
+
+                case 'C':
+                        cache_dir = optarg;
+                        break;
+
+                case 'T':
+                        report_enable = 1;
+                        break;
+
+                case 'W':
+                        program_enable = 1;
+                        break;
 
-        start_tune_process();
-        while (yylex() != 0) {
+                default:
+                        print_usage();
+                        exit(EXIT_FAILURE);
+                }
         }
 
-        fclose(yyaskB);
-        fclose(yyin);
-#endif /* DISABLE_TUNE */
+        char** in_path = argv + optind;
+        const int32_t in_path_len = argc - optind;
+
+        if (in_path_len < 1) {
+                print_usage();
+                exit(EXIT_FAILURE);
+        }
+
+        cache_init(cache_dir);
+
+        /* 入力ファイル.nb 出力ファイル.ask の形式 */
+        if (in_path_len == 2 && !is_filename_extention_nb(in_path[1])) {
+                compile_cached(in_path[0], in_path[1]);
+                return EXIT_SUCCESS;
+        }
+
+        /* 入力ファイル1.nb 入力ファイル2.nb ... の形式
+         * 全ての入力ファイルを翻訳単位ごとにコンパイルする。
+         * -j が指定された場合は、複数のスレッドで並列にコンパイルする。
+         */
+        if (jobs == 1) {
+                int32_t i;
+                for (i = 0; i < in_path_len; i++)
+                        compile_file(in_path[i]);
+        } else {
+                compile_parallel(in_path, in_path_len, jobs);
+        }
 
         return EXIT_SUCCESS;
 }
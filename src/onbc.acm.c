@@ -26,6 +26,7 @@
 #include "onbc.uint.h"
 #include "onbc.double.h"
 #include "onbc.ptr.h"
+#include "onbc.stack.h"
 #include "onbc.acm.h"
 
 /* 共通アキュムレーター
@@ -67,9 +68,11 @@ var_common_operation_new(struct Var* avar,
 
         /* We assume it the RValue which is in condition that
          * an value was acquired in stack.
+         * (単項演算の avar はオペランドのコピーなので、即値の属性を外しておく)
          */
         avar->base_ptr = -1;
         avar->is_lvalue = 0;
+        avar->type &= ~TYPE_LITERAL;
 
         push_stack(areg);
 }
@@ -144,7 +147,7 @@ var_unary_operation_new(const char* areg,
         lvar = var_realize_read_value(lvar, lreg);
 
         struct Var* avar = new_var();
-        *avar = *lvar;
+        var_copy(avar, lvar);
 
         var_common_operation_new(avar, areg, lreg, NULL,
                                  __func_sint, __func_uint,
@@ -478,7 +481,12 @@ __var_func_assignment_new(const char* areg,
 {
         rvar = var_realize_read_value(rvar, rreg);
 
-        if (lvar->is_lvalue)
+        /* register 変数の場合は、アドレスを経由せずにレジスターへ直接代入する */
+        const int32_t is_register = var_is_register(lvar);
+
+        if (is_register)
+                ;
+        else if (lvar->is_lvalue)
                 lvar = var_pre_read_value(lvar, lreg);
         else
                 yyerror("syntax err: 有効な左辺値ではないので代入できません");
@@ -492,10 +500,14 @@ __var_func_assignment_new(const char* areg,
 #endif /* DEBUG_VAR_FUNC_ASSIGNMENT_NEW */
 
         struct Var* avar = new_var();
-        *avar = *lvar;
+        var_copy(avar, lvar);
 
         cast_regval(avar, rvar, rreg);
-        write_mem(rreg, lreg);
+
+        if (is_register)
+                pA("%s = %s;", var_register_name(lvar), rreg);
+        else
+                write_mem(rreg, lreg);
 
         push_stack(rreg);
 
@@ -504,6 +516,34 @@ __var_func_assignment_new(const char* areg,
          */
         avar->base_ptr = -1;
         avar->is_lvalue = 0;
+        avar->regvar = -1;
 
         return avar;
 }
+
+/* 比較演算と条件分岐の融合
+ *
+ * l ope r の結果を 0/1 の値としてスタックへ積まずに、真であれば直接 label へジャンプする。
+ * ope には比較演算子の表記 ("==", "<" 等) を渡す。
+ * 比較前の型変換は var_binary_operation_new() と同じで、各型の __func_{eq,ne,lt,gt,le,ge}_*() と同じ比較となる。
+ */
+void
+__var_func_compare_branch(const char* ope, const int32_t label,
+                          struct Var* lvar, const char* lreg,
+                          struct Var* rvar, const char* rreg)
+{
+        rvar = var_normalization_type(rvar);
+        rvar = var_realize_read_value(rvar, rreg);
+
+        lvar = var_normalization_type(lvar);
+        lvar = var_realize_read_value(lvar, lreg);
+
+        struct Var* avar = new_var_binary_type_promotion(lvar, rvar);
+        var_binary_implicit_type_promotion(avar, lvar, lreg, rvar, rreg);
+
+        if (avar->indirect_len == 0 && var_is_void(avar))
+                yyerror("syntax err: void 型への演算を行いました");
+
+        stack_cache_flush();
+        pA("if (%s %s %s) {PLIMM(P3F, %d);}", lreg, ope, rreg, label);
+}
@@ -85,5 +85,9 @@ struct Var*
 __var_func_assignment_new(const char* areg,
                           struct Var* lvar, const char* lreg,
                           struct Var* rvar, const char* rreg);
+void
+__var_func_compare_branch(const char* ope, const int32_t label,
+                          struct Var* lvar, const char* lreg,
+                          struct Var* rvar, const char* rreg);
 
 #endif /* __ONBC_ACM_H__ */
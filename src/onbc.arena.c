@@ -0,0 +1,105 @@
+/* onbc.arena.c
+ * Copyright (C) 2013 Takeutch Kemeco
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "onbc.print.h"
+#include "onbc.arena.h"
+
+/* EC 木と、その Var のためのアリーナ
+ *
+ * EC や Var は構文解析中に大量に生成されるが、個別には開放されない。
+ * これらは external_declaration 1つ分の翻訳が終われば不要になるので、
+ * 固定長のチャンクから先頭へ詰めて確保し (bump pointer)、翻訳が終わった時点で arena_reset() でまとめて開放する。
+ *
+ * チャンクは開放せずに次の external_declaration でも使いまわすので、
+ * コンパイラーのメモリー使用量は、最大の external_declaration の分で頭打ちとなる。
+ */
+
+#define ARENA_CHUNK_SIZE 0x10000
+#define ARENA_ALIGN 8
+
+struct ArenaChunk {
+        struct ArenaChunk* next;
+        size_t size;            /* data[] の大きさ */
+        size_t used;            /* data[] の使用済みの大きさ */
+        char data[];
+};
+
+/* チャンクのリストの先頭と、現在確保に用いているチャンク */
+static __thread struct ArenaChunk* arena_head = NULL;
+static __thread struct ArenaChunk* arena_cur = NULL;
+
+static struct ArenaChunk* new_arena_chunk(const size_t size)
+{
+        struct ArenaChunk* chunk = malloc(sizeof(*chunk) + size);
+        if (chunk == NULL)
+                yyerror("system err: new_arena_chunk(), malloc()");
+
+        chunk->next = NULL;
+        chunk->size = size;
+        chunk->used = 0;
+
+        return chunk;
+}
+
+/* アリーナから size バイトの領域を確保して返す
+ * 領域は次の arena_reset() まで有効。（個別に free() してはならない）
+ */
+void* arena_alloc(const size_t size)
+{
+        const size_t aligned_size = (size + (ARENA_ALIGN - 1)) & ~((size_t)ARENA_ALIGN - 1);
+
+        if (arena_cur == NULL) {
+                arena_head = new_arena_chunk(ARENA_CHUNK_SIZE);
+                arena_cur = arena_head;
+        }
+
+        /* 現在のチャンクに収まらなければ、後続のチャンクへ進む。
+         * 収まるチャンクが無ければ、新たなチャンクを現在のチャンクの直後へ挿入する。
+         */
+        while (arena_cur->used + aligned_size > arena_cur->size) {
+                struct ArenaChunk* next = arena_cur->next;
+                if (next == NULL || aligned_size > next->size) {
+                        const size_t chunk_size = (aligned_size > ARENA_CHUNK_SIZE) ? aligned_size : ARENA_CHUNK_SIZE;
+                        struct ArenaChunk* chunk = new_arena_chunk(chunk_size);
+                        chunk->next = next;
+                        arena_cur->next = chunk;
+                        next = chunk;
+                }
+
+                arena_cur = next;
+        }
+
+        void* p = arena_cur->data + arena_cur->used;
+        arena_cur->used += aligned_size;
+
+        return p;
+}
+
+/* アリーナから確保した全ての領域をまとめて開放する
+ * （チャンク自体は開放せずに、次回以降の arena_alloc() で再利用する）
+ */
+void arena_reset(void)
+{
+        struct ArenaChunk* chunk;
+        for (chunk = arena_head; chunk != NULL; chunk = chunk->next)
+                chunk->used = 0;
+
+        arena_cur = arena_head;
+}
@@ -0,0 +1,12 @@
+#include <stddef.h>
+
+#ifndef __ONBC_ARENA_H__
+#define __ONBC_ARENA_H__
+
+/* アリーナ（一括開放するメモリー領域）関連
+ */
+
+void* arena_alloc(const size_t size);
+void arena_reset(void);
+
+#endif /* __ONBC_ARENA_H__ */
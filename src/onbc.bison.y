@@ -43,9 +43,16 @@
 #include "onbc.cast.h"
 #include "onbc.ec.h"
 #include "onbc.struct.h"
+#include "onbc.arena.h"
+#include "onbc.program.h"
 
 #define YYMAXDEPTH 0x10000000
 
+/* 字句解析は、現在のスレッドのスキャナーを用いて行う
+ */
+extern __thread void* cur_yyscanner;
+#define yylex(lvalp) onbc_lex(lvalp, cur_yyscanner)
+
 void init_tmp(void)
 {
         pB("SInt32 tmp00:R17;");
@@ -63,10 +70,9 @@ void init_tmp(void)
  */
 void init_all(void)
 {
-        pB("#include \"osecpu_ask.h\"\n");
-
-        pB("LOCALLABELS(%d);\n", LABEL_INDEX_LEN);
-
+        /* #include "osecpu_ask.h" と LOCALLABELS() は、使用したラベル数が確定した後に
+         * main.c のマージ時に先頭へ出力する。
+         */
         init_mem();
         init_heap();
         init_stack();
@@ -75,6 +81,7 @@ void init_all(void)
         init_labelstack();
         init_eoe_arg();
         init_tmp();
+        init_regvar();
 }
 
 %}
@@ -83,6 +90,7 @@ void init_all(void)
         int32_t ival;
         float fval;
         char sval[0x1000];
+        const char* iden;
         int32_t ival_list[0x400];
         struct VarList* varlistptr;
         struct Var* varptr;
@@ -91,6 +99,12 @@ void init_all(void)
         struct EC* ec;
 }
 
+%code {
+int onbc_lex(YYSTYPE* yylval_param, void* yyscanner);
+}
+
+%define api.pure
+
 %token __STATE_IF __STATE_ELSE
 %token __STATE_SWITCH __STATE_CASE __STATE_DEFAULT
 %token __OPE_SELECTION
@@ -146,10 +160,11 @@ void init_all(void)
 %type <fval> __FLOATING_CONSTANT
 %type <ival> __CHARACTER_CONSTANT
 %type <sval> __STRING_CONSTANT string
-%type <sval> __IDENTIFIER __DEFINE_LABEL
+%type <iden> __IDENTIFIER __DEFINE_LABEL
 
 %type <ival> declaration_specifiers
 %type <ival> type_specifier type_specifier_unit
+%type <ival> storage_class_specifier
 %type <ival> pointer
 
 %type <ec> function_definition
@@ -198,7 +213,7 @@ void init_all(void)
 
 %type <ival_list> initializer_param
 
-%type <sval> define_struct
+%type <ec> define_struct
 %type <structspecptr> initializer_struct_member_list
 %type <varlistptr> initializer_struct_member
 
@@ -208,20 +223,28 @@ void init_all(void)
 
 %%
 
+/* 左再帰にしているので、external_declaration は還元される毎にその場で翻訳され、
+ * 構文解析のスタックはプログラムの長さに依らず、入れ子の深さ分しか伸びない。
+ */
 translation_unit
-        : __EOF {
+        : external_declaration_list __EOF {
+                program_end();
+                labellist_check_undefined();
                 YYACCEPT;
         }
-        | external_declaration
-        | external_declaration translation_unit
+        ;
+
+external_declaration_list
+        : /* empty */
+        | external_declaration_list external_declaration
         ;
 
 external_declaration
         : function_definition {
-                translate_ec($1);
+                program_add($1);
         }
         | declaration {
-                translate_ec($1);
+                program_add($1);
         }
         ;
 
@@ -256,20 +279,9 @@ declaration_list
                 ec->type_expression = EC_DECLARATION_LIST;
                 $$ = ec;
         }
-        | declaration {
-                struct EC* ec = new_ec();
-                ec->type_expression = EC_DECLARATION_LIST;
-                ec->child_ptr[0] = $1;
-                ec->child_len = 1;
-                $$ = ec;
-        }
-        | declaration declaration_list {
-                struct EC* ec = new_ec();
-                ec->type_expression = EC_DECLARATION_LIST;
-                ec->child_ptr[0] = $1;
-                ec->child_ptr[1] = $2;
-                ec->child_len = 2;
-                $$ = ec;
+        | declaration_list declaration {
+                ec_list_append($1, $2);
+                $$ = $1;
         }
         ;
 
@@ -281,6 +293,15 @@ declaration_specifiers
         | type_specifier declaration_specifiers {
                 $$ = $1 | $2;
         }
+        | storage_class_specifier declaration_specifiers {
+                $$ = $1 | $2;
+        }
+        ;
+
+storage_class_specifier
+        : __TYPE_REGISTER {
+                $$ = TYPE_REGISTER;
+        }
         ;
 
 type_specifier
@@ -357,7 +378,7 @@ direct_declarator
         : __IDENTIFIER {
                 struct EC* ec = new_ec();
                 ec->type_expression = EC_DIRECT_DECLARATOR;
-                strcpy(ec->var->iden, $1);
+                ec->var->iden = $1;
                 $$ = ec;
         }
         | __LB declarator __RB {
@@ -366,8 +387,7 @@ direct_declarator
         | direct_declarator __ARRAY_LB __INTEGER_CONSTANT __ARRAY_RB {
                 struct EC* ec = $1;
                 ec->var->type |= TYPE_ARRAY;
-                ec->var->unit_len[ec->var->dim_len] = $3;
-                ec->var->dim_len++;
+                var_push_dim(ec->var, $3);
                 $$ = ec;
 
         }
@@ -462,15 +482,14 @@ initializer
 
 initializer_struct_member
         : type_specifier pointer __IDENTIFIER initializer_param {
-                struct VarList* vl = malloc(sizeof(*vl));
-                vl->var[0] = structmemberspec_new($3, &($4[1]), $4[0], $2, $1);
-                vl->varlist_len = 1;
+                struct VarList* vl = new_varlist();
+                varlist_push(vl, structmemberspec_new($3, &($4[1]), $4[0], $2, $1));
 
                 $$ = vl;
         }
         | initializer_struct_member __OPE_COMMA pointer __IDENTIFIER initializer_param {
                 const int32_t type = $1->var[0]->type;
-                $1->var[$1->varlist_len] = structmemberspec_new($4, &($5[1]), $5[0], $3, type);
+                varlist_push($1, structmemberspec_new($4, &($5[1]), $5[0], $3, type));
 
                 $$ = $1;
         }
@@ -488,7 +507,7 @@ initializer_struct_member_list
                         structspec_add_member(spec, $1->var[i]);
                 }
 
-                free($1);
+                delete_varlist($1);
 
                 $$ = spec;
         }
@@ -498,7 +517,7 @@ initializer_struct_member_list
                         structspec_add_member($1, $2->var[i]);
                 }
 
-                free($2);
+                delete_varlist($2);
 
                 $$ = $1;
         }
@@ -510,6 +529,11 @@ define_struct
         {
                 structspec_set_iden($4, $2);
                 structspec_ptrlist_add($4);
+
+                /* 構造体の定義はコンパイル時に完結するので、翻訳時には何もしない空の宣言リストを返す */
+                struct EC* ec = new_ec();
+                ec->type_expression = EC_DECLARATION_LIST;
+                $$ = ec;
         }
         ;
 
@@ -569,31 +593,25 @@ labeled_statement
         : __DEFINE_LABEL {
                 struct EC* ec = new_ec();
                 ec->type_expression = EC_LABELED_STATEMENT;
-                strcpy(ec->var->iden, $1);
+                ec->var->iden = $1;
                 $$ = ec;
         }
         ;
 
+/* 文のリストは左再帰で EC_STATEMENT_LIST へ追加していくので、構文解析のスタックは文の数に依らない。
+ * ただし関数本体（compound_statement）の文は、関数の宣言部を先に翻訳する必要が有るので、
+ * 関数定義全体が external_declaration として還元されるまで EC として保持され、その後まとめて翻訳される。
+ * （メモリー使用量が文の数に比例するのは関数1つ分までで、トップレベルの文は還元毎に翻訳して開放する）
+ */
 statement_list
         : /* empty */ {
                 struct EC* ec = new_ec();
                 ec->type_expression = EC_STATEMENT_LIST;
                 $$ = ec;
         }
-        | statement {
-                struct EC* ec = new_ec();
-                ec->type_expression = EC_STATEMENT_LIST;
-                ec->child_ptr[0] = $1;
-                ec->child_len = 1;
-                $$ = ec;
-        }
         | statement_list statement {
-                struct EC* ec = new_ec();
-                ec->type_expression = EC_STATEMENT_LIST;
-                ec->child_ptr[0] = $1;
-                ec->child_ptr[1] = $2;
-                ec->child_len = 2;
-                $$ = ec;
+                ec_list_append($1, $2);
+                $$ = $1;
         }
         ;
 
@@ -678,7 +696,7 @@ jump_statement
                 struct EC* ec = new_ec();
                 ec->type_expression = EC_JUMP_STATEMENT;
                 ec->type_operator = EC_OPE_GOTO;
-                strcpy(ec->var->iden, $2);
+                ec->var->iden = $2;
                 $$ = ec;
         }
         | __STATE_RETURN expression __DECL_END {
@@ -728,10 +746,28 @@ conditional_expression
 
 logical_or_expression
         : logical_and_expression
+        | logical_or_expression __OPE_LOGICAL_OR logical_and_expression {
+                struct EC* ec = new_ec();
+                ec->type_expression = EC_CALC;
+                ec->type_operator = EC_OPE_LOGICAL_OR;
+                ec->child_ptr[0] = $1;
+                ec->child_ptr[1] = $3;
+                ec->child_len = 2;
+                $$ = ec;
+        }
         ;
 
 logical_and_expression
         : inclusive_or_expression
+        | logical_and_expression __OPE_LOGICAL_AND inclusive_or_expression {
+                struct EC* ec = new_ec();
+                ec->type_expression = EC_CALC;
+                ec->type_operator = EC_OPE_LOGICAL_AND;
+                ec->child_ptr[0] = $1;
+                ec->child_ptr[1] = $3;
+                ec->child_len = 2;
+                $$ = ec;
+        }
         ;
 
 inclusive_or_expression
@@ -996,7 +1032,7 @@ postfix_expression
                 ec->type_operator = EC_OPE_FUNCTION;
 
                 ec->var->type = TYPE_FUNCTION;
-                strcpy(ec->var->iden, $1);
+                ec->var->iden = $1;
 
                 ec->child_ptr[0] = $3;
                 ec->child_len = 1;
@@ -1009,7 +1045,7 @@ primary_expression
                 struct EC* ec = new_ec();
                 ec->type_expression = EC_PRIMARY;
                 ec->type_operator = EC_OPE_VARIABLE;
-                strcpy(ec->var->iden, $1);
+                ec->var->iden = $1;
                 ec->child_len = 0;
                 $$ = ec;
         }
@@ -1056,7 +1092,7 @@ inline_assembler_statement
                 struct EC* ec = new_ec();
                 ec->type_expression = EC_INLINE_ASSEMBLER_STATEMENT;
                 ec->type_operator = EC_OPE_ASM_STATEMENT;
-                ec->var->const_variable = malloc(strlen($3) + 1);
+                ec->var->const_variable = arena_alloc(strlen($3) + 1);
                 strcpy(ec->var->const_variable, $3);
                 $$ = ec;
         }
@@ -1066,7 +1102,7 @@ inline_assembler_statement
                 ec->type_operator = EC_OPE_ASM_SUBST_VTOR;
                 ec->child_ptr[0] = $5;
                 ec->child_len = 1;
-                ec->var->const_variable = malloc(strlen($3) + 1);
+                ec->var->const_variable = arena_alloc(strlen($3) + 1);
                 strcpy(ec->var->const_variable, $3);
                 $$ = ec;
         }
@@ -1076,7 +1112,7 @@ inline_assembler_statement
                 ec->type_operator = EC_OPE_ASM_SUBST_RTOV;
                 ec->child_ptr[0] = $3;
                 ec->child_len = 1;
-                ec->var->const_variable = malloc(strlen($5) + 1);
+                ec->var->const_variable = arena_alloc(strlen($5) + 1);
                 strcpy(ec->var->const_variable, $5);
                 $$ = ec;
         }
@@ -1086,13 +1122,15 @@ constant
         : __INTEGER_CONSTANT {
                 struct EC* ec = new_ec();
                 ec->type_expression = EC_CONSTANT;
-                sprintf(ec->var->iden, "@literal%d", $1);
+                char iden[IDENLIST_STR_LEN];
+                sprintf(iden, "@literal%d", $1);
+                ec->var->iden = iden_intern(iden);
 
                 ec->var->dim_len = 0;
                 ec->var->indirect_len = 0;
                 ec->var->type = TYPE_SIGNED | TYPE_INT | TYPE_LITERAL;
 
-                ec->var->const_variable = malloc(sizeof(int));
+                ec->var->const_variable = arena_alloc(sizeof(int));
                 *((int*)(ec->var->const_variable)) = $1;
 
                 $$ = ec;
@@ -1100,13 +1138,15 @@ constant
         | __CHARACTER_CONSTANT {
                 struct EC* ec = new_ec();
                 ec->type_expression = EC_CONSTANT;
-                sprintf(ec->var->iden, "@literal%d", $1);
+                char iden[IDENLIST_STR_LEN];
+                sprintf(iden, "@literal%d", $1);
+                ec->var->iden = iden_intern(iden);
 
                 ec->var->dim_len = 0;
                 ec->var->indirect_len = 0;
                 ec->var->type = TYPE_SIGNED | TYPE_CHAR | TYPE_LITERAL;
 
-                ec->var->const_variable = malloc(sizeof(int));
+                ec->var->const_variable = arena_alloc(sizeof(int));
                 *((int*)(ec->var->const_variable)) = $1;
 
                 $$ = ec;
@@ -1114,7 +1154,9 @@ constant
         | __FLOATING_CONSTANT {
                 struct EC* ec = new_ec();
                 ec->type_expression = EC_CONSTANT;
-                sprintf(ec->var->iden, "@literal%20.20f", $1);
+                char iden[IDENLIST_STR_LEN];
+                sprintf(iden, "@literal%20.20f", $1);
+                ec->var->iden = iden_intern(iden);
 
                 ec->var->dim_len = 0;
                 ec->var->indirect_len = 0;
@@ -1125,7 +1167,7 @@ constant
                 int32_t ia = ((int32_t)a) << 16;
                 int32_t ib = ((int32_t)(0x0000ffff * b)) & 0x0000ffff;
 
-                ec->var->const_variable = malloc(sizeof(int));
+                ec->var->const_variable = arena_alloc(sizeof(int));
                 *((int*)(ec->var->const_variable)) = ia | ib; /* 実際は固定小数なのでint */
 
                 $$ = ec;
@@ -0,0 +1,284 @@
+/* onbc.cache.c
+ * Copyright (C) 2013 Takeutch Kemeco
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "config.h"
+#include "onbc.cache.h"
+#include "onbc.hash.h"
+#include "onbc.file.h"
+#include "onbc.program.h"
+
+/* コンパイル結果のキャッシュ
+ *
+ * 入力ファイルと、それが #include する全てのファイル（再帰的に辿る）の内容、
+ * およびコンパイラーのバージョンとフラグからハッシュ値（キー）を作り、
+ * <cache_dir>/<キー>.ask へコンパイル結果を保存しておく。
+ * 次回、同じキーであれば、字句解析・構文解析・変換を全て省略してキャッシュをコピーする。
+ *
+ * #include の検出は、ソースを文字列として走査して行う。
+ * #ifdef 等で実際には読まれないファイルも含まれるが、キーが余分に変化しやすくなるだけで、
+ * 誤ったキャッシュが使われることは無い。
+ */
+
+/* キャッシュディレクトリー。NULL の場合はキャッシュを使わない。
+ * スレッドを作る前に cache_init() で一度だけ設定し、以後は読むだけ。
+ */
+static char* cache_dir = NULL;
+
+/* キーの元になる、コンパイラーのバージョンとフラグ */
+#ifndef DISABLE_TUNE
+#define CACHE_COMPILER_ID PACKAGE_NAME " " VERSION " tune"
+#else
+#define CACHE_COMPILER_ID PACKAGE_NAME " " VERSION " notune"
+#endif /* DISABLE_TUNE */
+
+/* FNV-1a 64bit ハッシュ */
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t fnv1a(uint64_t hash, const char* src, const size_t len)
+{
+        size_t i;
+        for (i = 0; i < len; i++) {
+                hash ^= (unsigned char)src[i];
+                hash *= FNV_PRIME;
+        }
+
+        return hash;
+}
+
+/* ファイルの内容を全て読み出し、malloc() したバッファーで返す。
+ * 失敗した場合は NULL を返す。（*len には長さがセットされる。終端の '\0' は長さに含まない）
+ */
+static char* read_all_file(const char* path, size_t* len)
+{
+        FILE* fp = fopen(path, "rb");
+        if (fp == NULL)
+                return NULL;
+
+        size_t size = 0x1000;
+        char* buf = malloc(size);
+        *len = 0;
+
+        while (buf != NULL) {
+                *len += fread(buf + *len, 1, size - *len - 1, fp);
+                if (*len < size - 1)
+                        break;
+
+                size *= 2;
+                char* tmp = realloc(buf, size);
+                if (tmp == NULL)
+                        free(buf);
+
+                buf = tmp;
+        }
+
+        fclose(fp);
+
+        if (buf != NULL)
+                buf[*len] = '\0';
+
+        return buf;
+}
+
+/* buf を path へ書き出す。失敗した場合は -1 を返す。
+ */
+static int32_t write_all_file(const char* path, const char* buf, const size_t len)
+{
+        FILE* fp = fopen(path, "wb");
+        if (fp == NULL)
+                return -1;
+
+        const size_t n = fwrite(buf, 1, len, fp);
+        if (fclose(fp) != 0 || n != len)
+                return -1;
+
+        return 0;
+}
+
+/* path のファイル名と内容をハッシュに加え、その中の #include "..." を再帰的に辿る。
+ * 読めないファイルがあった場合は -1 を返す。
+ * visit はキー計算中に辿ったファイル名のテーブル。同じファイルを2度辿らないためのもの。
+ */
+static int32_t cache_hash_file(uint64_t* hash, struct HashTable* visit, const char* path)
+{
+        if (hash_table_search(visit, path) != NULL)
+                return 0;
+
+        hash_table_insert(visit, path, visit);
+
+        /* 内容は字句解析と共有のキャッシュから得る（コンパイル時に再び読み込まずに済む） */
+        struct SourceFile* file = source_file_load(path);
+        if (file == NULL)
+                return -1;
+
+        *hash = fnv1a(*hash, path, strlen(path) + 1);
+        *hash = fnv1a(*hash, file->buf, file->len);
+
+        /* #include "ファイル名" を探して、そのファイルも辿る。
+         * （ファイル名は flex 側と同様に、カレントディレクトリーからの相対パスとして扱う）
+         */
+        int32_t ret = 0;
+        const char* p = file->buf;
+        while (ret == 0 && (p = strstr(p, "#include")) != NULL) {
+                p += strlen("#include");
+                while (*p == ' ' || *p == '\t')
+                        p++;
+
+                if (*p != '"')
+                        continue;
+
+                const char* head = p + 1;
+                const char* tail = strchr(head, '"');
+                if (tail == NULL)
+                        break;
+
+                const size_t include_path_len = tail - head;
+                if (include_path_len == 0)
+                        break;
+
+                char* include_path = malloc(include_path_len + 1);
+                if (include_path == NULL)
+                        return -1;
+
+                memcpy(include_path, head, include_path_len);
+                include_path[include_path_len] = '\0';
+
+                ret = cache_hash_file(hash, visit, include_path);
+                free(include_path);
+                p = tail + 1;
+        }
+
+        return ret;
+}
+
+/* キャッシュディレクトリーを設定する。
+ * dir が NULL の場合は環境変数 ONBC_CACHE_DIR を用いる。どちらも無ければキャッシュは使わない。
+ */
+void cache_init(const char* dir)
+{
+        if (dir == NULL)
+                dir = getenv("ONBC_CACHE_DIR");
+
+        if (dir == NULL || dir[0] == '\0')
+                return;
+
+        cache_dir = strdup(dir);
+        mkdir(cache_dir, 0777);
+}
+
+/* in_path を out_path へコンパイルする場合のキャッシュのキーを key へ16進文字列でセットする。
+ * キャッシュを使わない場合や、入力ファイル群の一部が読めなかった場合は -1 を返す。
+ */
+int32_t cache_key(char* key, const char* in_path, const char* out_path)
+{
+        /* 標準入出力はファイルとして読み書きできないので、キャッシュしない */
+        if (cache_dir == NULL || strcmp(in_path, "-") == 0 || strcmp(out_path, "-") == 0)
+                return -1;
+
+        uint64_t hash = FNV_OFFSET_BASIS;
+        hash = fnv1a(hash, CACHE_COMPILER_ID, strlen(CACHE_COMPILER_ID) + 1);
+
+        /* --whole-program の有無でコンパイル結果が変わり得るので、キーに含める */
+        hash = fnv1a(hash, (const char*)&program_enable, sizeof(program_enable));
+
+        struct HashTable* visit = new_hash_table(0x40, NULL);
+        const int32_t ret = cache_hash_file(&hash, visit, in_path);
+        delete_hash_table(visit);
+
+        if (ret != 0)
+                return -1;
+
+        sprintf(key, "%016llx", (unsigned long long)hash);
+        return 0;
+}
+
+/* key のキャッシュファイル名を dst へセットする。
+ * dst には 0x1000 + CACHE_KEY_LEN 以上のバッファーを渡すこと。
+ */
+static void cache_path(char* dst, const char* key)
+{
+        snprintf(dst, 0x1000 + CACHE_KEY_LEN, "%s/%s.ask", cache_dir, key);
+}
+
+/* key のキャッシュが存在すれば、その内容を out_path へ書き出して 0 を返す。
+ * 存在しなければ -1 を返す。
+ */
+int32_t cache_fetch(const char* key, const char* out_path)
+{
+        char path[0x1000 + CACHE_KEY_LEN];
+        cache_path(path, key);
+
+        size_t len;
+        char* buf = read_all_file(path, &len);
+        if (buf == NULL)
+                return -1;
+
+        const int32_t ret = write_all_file(out_path, buf, len);
+        free(buf);
+
+        if (ret != 0) {
+                printf("file err: ファイル %s の書き込みに失敗しました\n", out_path);
+                exit(EXIT_FAILURE);
+        }
+
+        return 0;
+}
+
+/* コンパイル結果 out_path を key のキャッシュとして保存する。
+ * 並列コンパイル中に同じキーを同時に保存しても壊れないように、一時ファイルへ書いてから rename() する。
+ * 保存に失敗してもコンパイル自体には影響しないので、エラーにはしない。
+ */
+void cache_store(const char* key, const char* out_path)
+{
+        size_t len;
+        char* buf = read_all_file(out_path, &len);
+        if (buf == NULL)
+                return;
+
+        char path[0x1000 + CACHE_KEY_LEN];
+        cache_path(path, key);
+
+        char tmp_path[0x1000 + CACHE_KEY_LEN + 8];
+        sprintf(tmp_path, "%s.XXXXXX", path);
+
+        int fd = mkstemp(tmp_path);
+        if (fd == -1) {
+                free(buf);
+                return;
+        }
+
+        FILE* fp = fdopen(fd, "wb");
+        if (fp == NULL) {
+                close(fd);
+                unlink(tmp_path);
+                free(buf);
+                return;
+        }
+
+        const size_t n = fwrite(buf, 1, len, fp);
+        if (fclose(fp) != 0 || n != len || rename(tmp_path, path) != 0)
+                unlink(tmp_path);
+
+        free(buf);
+}
@@ -0,0 +1,14 @@
+#include <stdint.h>
+
+#ifndef __ONBC_CACHE_H__
+#define __ONBC_CACHE_H__
+
+/* キャッシュのキー文字列の長さ（終端を含む） */
+#define CACHE_KEY_LEN 17
+
+void cache_init(const char* dir);
+int32_t cache_key(char* key, const char* in_path, const char* out_path);
+int32_t cache_fetch(const char* key, const char* out_path);
+void cache_store(const char* key, const char* out_path);
+
+#endif /* __ONBC_CACHE_H__ */
@@ -31,9 +31,9 @@ struct Var* new_var_binary_type_promotion(struct Var* lvar, struct Var* rvar)
         struct Var* avar = new_var();
 
         if (lvar->indirect_len >= 1) {
-                *avar = *lvar;
+                var_copy(avar, lvar);
         } else if (rvar->indirect_len >= 1) {
-                *avar = *rvar;
+                var_copy(avar, rvar);
         } else {
                 if (var_is_void(lvar) || var_is_void(rvar)) {
                         avar->type = TYPE_VOID;
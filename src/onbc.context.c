@@ -0,0 +1,96 @@
+/* onbc.context.c
+ * Copyright (C) 2013 Takeutch Kemeco
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "onbc.print.h"
+#include "onbc.iden.h"
+#include "onbc.var.h"
+#include "onbc.struct.h"
+#include "onbc.label.h"
+#include "onbc.ec.h"
+#include "onbc.func.h"
+#include "onbc.report.h"
+#include "onbc.arena.h"
+#include "onbc.program.h"
+#include "onbc.context.h"
+
+void init_lex(void);
+void free_lex(void);
+
+/* 文字列を複製して返す
+ */
+static char* context_strdup(const char* src)
+{
+        char* dst = malloc(strlen(src) + 1);
+        if (dst == NULL)
+                yyerror("system err: context_strdup(), malloc()");
+
+        strcpy(dst, src);
+        return dst;
+}
+
+/* 翻訳単位のコンテキストを生成する。
+ * 同時に、各モジュールが保持しているコンパイラーの状態を全て初期状態へ戻す。
+ *
+ * コンテキストは1つのスレッドにつき同時に1つだけ存在できる。（前のコンテキストを delete_context() してから生成すること）
+ * 別々のスレッドであれば、それぞれ独立したコンテキストで同時にコンパイルできる。
+ */
+struct Context* new_context(const char* in_path, const char* out_path)
+{
+        struct Context* ctx = malloc(sizeof(*ctx));
+        if (ctx == NULL)
+                yyerror("system err: new_context(), malloc()");
+
+        ctx->in_path = context_strdup(in_path);
+        ctx->out_path = context_strdup(out_path);
+        ctx->buf_a = NULL;
+        ctx->len_a = 0;
+        ctx->buf_b = NULL;
+        ctx->len_b = 0;
+
+        cur_context_generation++;
+
+        init_lex();
+        init_idenlist();
+        init_varlist();
+        init_structspec_ptrlist();
+        init_labellist();
+        init_ec();
+        init_program();
+        arena_reset();
+        report_init();
+
+        return ctx;
+}
+
+/* 翻訳単位のコンテキストを破棄する
+ */
+void delete_context(struct Context* ctx)
+{
+        free_lex();
+        free_program();
+
+        free(ctx->in_path);
+        free(ctx->out_path);
+        free(ctx->buf_a);
+        free(ctx->buf_b);
+        free(ctx);
+}
@@ -0,0 +1,25 @@
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef __ONBC_CONTEXT_H__
+#define __ONBC_CONTEXT_H__
+
+/* 翻訳単位（1つの .nb ファイル）のコンパイルに用いるコンテキスト
+ *
+ * in_path, out_path: 入力ファイル名、出力ファイル名
+ * buf_a, len_a: yyaskA へ書き出された内容と、その長さ
+ * buf_b, len_b: yyaskB へ書き出された内容と、その長さ
+ */
+struct Context {
+        char* in_path;
+        char* out_path;
+        char* buf_a;
+        size_t len_a;
+        char* buf_b;
+        size_t len_b;
+};
+
+struct Context* new_context(const char* in_path, const char* out_path);
+void delete_context(struct Context* ctx);
+
+#endif /* __ONBC_CONTEXT_H__ */
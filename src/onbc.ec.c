@@ -29,573 +29,945 @@
 #include "onbc.label.h"
 #include "onbc.acm.h"
 #include "onbc.ec.h"
+#include "onbc.report.h"
+#include "onbc.arena.h"
+#include "onbc.program.h"
+
+extern __thread int32_t linenumber;
+extern __thread const char* filepath;
 
 /* int a, b, c; 等、ノードを越えて型情報を共有したい場合に用いる一時変数。
  * __new_var_initializer() の引数に用いることを想定。
  */
-static int32_t cur_declaration_specifiers = 0;
+static __thread int32_t cur_declaration_specifiers = 0;
+
+static __thread int32_t windoffset = 0;
 
-static int32_t windoffset = 0;
+/* EC の変換処理で翻訳単位をまたいで保持される状態を初期化する
+ */
+void init_ec(void)
+{
+        cur_declaration_specifiers = 0;
+        windoffset = 0;
+}
 
 /* 白紙のECインスタンスをメモリー領域を確保して生成
+ * EC とその Var はアリーナから確保するので、external_declaration の翻訳後の arena_reset() でまとめて開放される。
  */
 struct EC* new_ec(void)
 {
-        struct EC* ec = malloc(sizeof(*ec));
-        if (ec == NULL)
-                yyerror("system err: new_ec(), malloc()");
+        struct EC* ec = arena_alloc(sizeof(*ec));
 
         ec->var = new_var();
         ec->type_operator = 0;
         ec->type_expression = 0;
         ec->child_len = 0;
+        ec->next = NULL;
+        ec->linenumber = linenumber;
+        ec->filepath = filepath;
+
+        report_count.ec_new++;
 
         return ec;
 }
 
-/* メモリー領域を開放してECインスタンスを消去
- * (枝(child_ptr[])も含めての開放ではない)
+/* ECインスタンスを消去
+ * EC はアリーナから確保されているので個別には開放せず、arena_reset() で開放される。
  */
 void delete_ec(struct EC* ec)
 {
-        free((void*)ec);
+}
+
+/* リストの EC (EC_STATEMENT_LIST, EC_DECLARATION_LIST) の末尾に item を追加する
+ */
+void ec_list_append(struct EC* list, struct EC* item)
+{
+        if (list->child_len == 0)
+                list->child_ptr[0] = item;
+        else
+                list->child_ptr[1]->next = item;
+
+        list->child_ptr[1] = item;
+        list->child_len = 2;
 }
 
 /* EC木のアセンブラへの翻訳関連
  */
 
-void translate_ec(struct EC* ec)
+/* 自身の翻訳処理を持たない EC 用（何もしない）
+ */
+static void translate_ec_nop(struct EC* ec)
 {
-        if ((ec->type_operator != EC_OPE_FUNCTION) &&
-            (ec->type_expression != EC_COMPOUND_STATEMENT) &&
-            (ec->type_expression != EC_SELECTION_STATEMENT) &&
-            (ec->type_expression != EC_ITERATION_STATEMENT) &&
-            (ec->type_expression != EC_INLINE_ASSEMBLER_STATEMENT) &&
-            (ec->type_expression != EC_DECLARATION) &&
-            (ec->type_expression != EC_DIRECT_DECLARATOR) &&
-            (ec->type_expression != EC_FUNCTION_DEFINITION) &&
-            (ec->type_expression != EC_PARAMETER_DECLARATION) &&
-            (ec->type_expression != EC_PARAMETER_LIST) &&
-            (ec->type_expression != EC_DECLARATOR) &&
-            (ec->type_expression != EC_PARAMETER_TYPE_LIST) &&
-            (ec->type_expression != EC_ARGUMENT_EXPRESSION_LIST) &&
-            (ec->type_expression != EC_CAST)) {
-                int32_t i;
-                for (i = 0; i < ec->child_len; i++) {
-                        translate_ec(ec->child_ptr[i]);
-                }
+}
+
+/* EC_FUNCTION_DEFINITION: 関数定義
+ */
+static void translate_ec_function_definition(struct EC* ec)
+{
+        const int32_t skip_label = cur_label_index_head++;
+        stack_cache_flush();
+        pA("PLIMM(P3F, %d);", skip_label);
+
+        translate_ec(ec->child_ptr[0]); /* 関数識別子、および引数 */
+        translate_ec(ec->child_ptr[1]); /* 関数のステートメント部 */
+
+        cur_declaration_specifiers = ec->var->type; /* 戻り値の型 */
+
+        /* 現在の関数からのリターン
+         * プログラムフローがこの位置へ至る状態は、関数内でreturnが実行されなかった場合。
+         * しかし、関数は expression なので、終了後に"必ず"スタックが +1 された状態でなければならないので、
+         * fixAにデフォルト値として 0 をセットし、 return 0 と同様の処理となる。
+         */
+        pA("fixA = 0;");
+        __define_user_function_return();
+
+        /* スコープ復帰位置をポップし、ローカルスコープから一段復帰する（コンパイル時）
+         */
+        local_varlist_scope_pop();
+
+        pA("LB(0, %d);", skip_label);
+}
+
+/* EC_DECLARATION: 宣言命令
+ */
+static void translate_ec_declaration(struct EC* ec)
+{
+        cur_declaration_specifiers = ec->var->type; /* 子ノードの型 */
+        translate_ec(ec->child_ptr[0]);
+        var_copy(ec->var, ec->child_ptr[0]->var);
+}
+
+/* EC_DECLARATION_LIST, EC_STATEMENT_LIST: リストの各要素を先頭から順に翻訳する
+ * 要素は next で連なっているので、リストの長さによって再帰が深くなることは無い。
+ */
+static void translate_ec_list(struct EC* ec)
+{
+        if (ec->child_len == 0)
+                return;
+
+        struct EC* item;
+        for (item = ec->child_ptr[0]; item != NULL; item = item->next)
+                translate_ec(item);
+}
+
+/* EC_INIT_DECLARATOR: 初期化を伴う宣言
+ */
+static void translate_ec_init_declarator(struct EC* ec)
+{
+        var_copy(ec->var, __var_func_assignment_new("fixA",
+                                                     ec->child_ptr[0]->var, "fixL",
+                                                     ec->child_ptr[1]->var, "fixR"));
+        var_read_value_dummy(ec->var); /* This return a state of stack +1 to 0. */
+}
+
+/* EC_DECLARATOR: 宣言
+ */
+static void translate_ec_declarator(struct EC* ec)
+{
+        if (ec->var->type & TYPE_FUNCTION)
+                cur_declaration_specifiers |= TYPE_FUNCTION;
+
+        if (cur_declaration_specifiers & TYPE_WIND)
+                ec->var->base_ptr = windoffset;
+
+        var_copy(ec->var, var_initializer_new(ec->var, cur_declaration_specifiers));
+
+        if (ec->var->type & TYPE_FUNCTION) {
+                const int32_t func_label = cur_label_index_head++;
 
-                if (ec->child_len >= 1)
-                        *(ec->var) = *(ec->child_ptr[0]->var);
+                struct Var* var = varlist_search(ec->var->iden);
+                var->base_ptr = func_label;
+
+                pA("LB(0, %d);", func_label);
+
+                translate_ec(ec->child_ptr[0]);
         }
+}
 
-        if (ec->type_expression == EC_FUNCTION_DEFINITION) {
-                const int32_t skip_label = cur_label_index_head++;
-                pA("PLIMM(P3F, %d);", skip_label);
+/* EC_PARAMETER_TYPE_LIST: 関数引数リストのラッパー
+ */
+static void translate_ec_parameter_type_list(struct EC* ec)
+{
+        /* スコープ復帰位置をプッシュし、一段深いローカルスコープの開始（コンパイル時）
+         */
+        local_varlist_scope_push();
 
-                translate_ec(ec->child_ptr[0]); /* 関数識別子、および引数 */
-                translate_ec(ec->child_ptr[1]); /* 関数のステートメント部 */
+        if (ec->child_len == 1) {
+                next_local_varlist_add_set_new_scope = 1;
+                windoffset = 0;
+                translate_ec(ec->child_ptr[0]);
+        }
+}
 
-                cur_declaration_specifiers = ec->var->type; /* 戻り値の型 */
+/* EC_PARAMETER_LIST: 関数引数リスト
+ */
+static void translate_ec_parameter_list(struct EC* ec)
+{
+        if (ec->child_len == 1) {
+                translate_ec(ec->child_ptr[0]);
+                var_copy(ec->var, ec->child_ptr[0]->var);
+        } else if (ec->child_len == 2) {
+                translate_ec(ec->child_ptr[0]);
 
-                /* 現在の関数からのリターン
-                 * プログラムフローがこの位置へ至る状態は、関数内でreturnが実行されなかった場合。
-                 * しかし、関数は expression なので、終了後に"必ず"スタックが +1 された状態でなければならないので、
-                 * fixAにデフォルト値として 0 をセットし、 return 0 と同様の処理となる。
-                 */
-                pA("fixA = 0;");
-                __define_user_function_return();
+                translate_ec(ec->child_ptr[1]);
+                var_copy(ec->var, ec->child_ptr[1]->var);
+        } else {
+                yyerror("system err: EC_PARAMETER_LIST");
+        }
+}
 
-                /* スコープ復帰位置をポップし、ローカルスコープから一段復帰する（コンパイル時）
-                 */
-                local_varlist_scope_pop();
+/* EC_PARAMETER_DECLARATION: 関数引数の宣言
+ */
+static void translate_ec_parameter_declaration(struct EC* ec)
+{
+        const int32_t old_windoffset = windoffset;
+        cur_declaration_specifiers = ec->var->type | TYPE_WIND;
+        translate_ec(ec->child_ptr[0]);
+        var_copy(ec->var, ec->child_ptr[0]->var);
+
+        windoffset = old_windoffset + ec->var->unit_total_len;
+
+#ifdef DEBUG_EC_PARAMETER_DECLARATION
+        pA_mes("after EC_PARAMETER_DECLARATION, ");
+        pA_mes("\\n");
+        pA_reg("stack_head");
+        pA_mes("\\n");
+        pA_reg("stack_frame");
+        pA_mes("\\n");
+        debug_stackframe(16);
+#endif /* DEBUG_EC_PARAMETER_DECLARATION */
+}
 
-                pA("LB(0, %d);", skip_label);
-        } else if (ec->type_expression == EC_DECLARATION) {
-                cur_declaration_specifiers = ec->var->type; /* 子ノードの型 */
+/* EC_COMPOUND_STATEMENT: 命令ブロック
+ */
+static void translate_ec_compound_statement(struct EC* ec)
+{
+        local_varlist_scope_push();   /* コンパイル時 */
+
+        if (ec->child_len == 2) {
                 translate_ec(ec->child_ptr[0]);
-                *(ec->var) = *(ec->child_ptr[0]->var);
-        } else if (ec->type_expression == EC_DECLARATION_LIST) {
-                /* 何もしない */
-        } else if (ec->type_expression == EC_INIT_DECLARATOR_LIST) {
-                /* 何もしない */
-        } else if (ec->type_expression == EC_INIT_DECLARATOR) {
-                *(ec->var) = *(__var_func_assignment_new("fixA",
-                                                         ec->child_ptr[0]->var, "fixL",
-                                                         ec->child_ptr[1]->var, "fixR"));
-                var_read_value_dummy(ec->var); /* This return a state of stack +1 to 0. */
-        } else if (ec->type_expression == EC_DECLARATOR) {
-                if (ec->var->type & TYPE_FUNCTION)
-                        cur_declaration_specifiers |= TYPE_FUNCTION;
-
-                if (cur_declaration_specifiers & TYPE_WIND)
-                        ec->var->base_ptr = windoffset;
-
-                *(ec->var) = *(var_initializer_new(ec->var, cur_declaration_specifiers));
-
-                if (ec->var->type & TYPE_FUNCTION) {
-                        const int32_t func_label = cur_label_index_head++;
-
-                        struct Var* var = varlist_search(ec->var->iden);
-                        var->base_ptr = func_label;
-
-                        pA("LB(0, %d);", func_label);
-
-                        translate_ec(ec->child_ptr[0]);
-                }
-        } else if (ec->type_expression == EC_DIRECT_DECLARATOR) {
-                /* 何もしない */
-        } else if (ec->type_expression == EC_PARAMETER_TYPE_LIST) {
-                /* スコープ復帰位置をプッシュし、一段深いローカルスコープの開始（コンパイル時）
+                translate_ec(ec->child_ptr[1]);
+        }
+
+        local_varlist_scope_pop();    /* コンパイル時 */
+}
+
+/* EC_LABELED_STATEMENT: ラベル定義
+ */
+static void translate_ec_labeled_statement(struct EC* ec)
+{
+        stack_cache_flush();
+        pA("LB(1, %d);", labellist_add(ec->var->iden));
+}
+
+/* EC_EXPRESSION_STATEMENT: expression命令
+ */
+static void translate_ec_expression_statement(struct EC* ec)
+{
+        if (ec->child_len != 0) {
+                /* As for the statement to belong to expression,
+                 * push may be left in the stack on end of time.
+                 * When a push to stack is left, We clean it.
                  */
-                local_varlist_scope_push();
+                var_read_value_dummy(ec->child_ptr[0]->var);
+        }
+}
 
-                if (ec->child_len == 1) {
-                        next_local_varlist_add_set_new_scope = 1;
-                        windoffset = 0;
-                        translate_ec(ec->child_ptr[0]);
+/* 比較演算の表記と、その否定の表記。 type_operator で引く */
+static const char* const translate_ec_compare_ope[EC_TYPE_OPERATOR_LEN] = {
+        [EC_OPE_EQ] = "==",
+        [EC_OPE_NE] = "!=",
+        [EC_OPE_LT] = "<",
+        [EC_OPE_GT] = ">",
+        [EC_OPE_LE] = "<=",
+        [EC_OPE_GE] = ">=",
+};
+
+static const char* const translate_ec_compare_inv_ope[EC_TYPE_OPERATOR_LEN] = {
+        [EC_OPE_EQ] = "!=",
+        [EC_OPE_NE] = "==",
+        [EC_OPE_LT] = ">=",
+        [EC_OPE_GT] = "<=",
+        [EC_OPE_LE] = ">",
+        [EC_OPE_GE] = "<",
+};
+
+/* 条件式 ec を評価し、その真偽が jump_if (1: 真, 0: 偽) と一致すれば label へジャンプする
+ *
+ * 比較演算、!、&&、|| をルートとする条件式は、0/1 の値をスタックへ積まずに、直接条件分岐へ変換する。
+ * &&、|| は短絡評価し、右辺は結果が確定しない場合のみ評価する。
+ * 整数の定数であれば、コンパイル時に分岐の有無を決める。
+ */
+static void translate_ec_branch(struct EC* ec, const int32_t label, const int32_t jump_if)
+{
+        if (ec->type_expression == EC_CONSTANT &&
+            var_is_immediate(ec->var) && ec->var->indirect_len == 0) {
+                const int32_t value = (*((int*)(ec->var->const_variable)) != 0);
+                if (value == jump_if) {
+                        stack_cache_flush();
+                        pA("PLIMM(P3F, %d);", label);
                 }
-        } else if (ec->type_expression == EC_PARAMETER_LIST) {
-                if (ec->child_len == 1) {
-                        translate_ec(ec->child_ptr[0]);
-                        *(ec->var) = *(ec->child_ptr[0]->var);
-                } else if (ec->child_len == 2) {
-                        translate_ec(ec->child_ptr[0]);
-
-                        translate_ec(ec->child_ptr[1]);
-                        *(ec->var) = *(ec->child_ptr[1]->var);
+
+                return;
+        }
+
+        if (ec->type_expression == EC_UNARY && ec->type_operator == EC_OPE_NOT) {
+                translate_ec_branch(ec->child_ptr[0], label, !jump_if);
+                return;
+        }
+
+        if (ec->type_expression == EC_CALC &&
+            (ec->type_operator == EC_OPE_LOGICAL_AND || ec->type_operator == EC_OPE_LOGICAL_OR)) {
+                /* && で偽、|| で真へジャンプする場合は、左辺と右辺の何れかで条件が成立すればよい */
+                const int32_t jump_on_either = (ec->type_operator == EC_OPE_LOGICAL_AND) ? 0 : 1;
+
+                if (jump_if == jump_on_either) {
+                        translate_ec_branch(ec->child_ptr[0], label, jump_if);
+                        translate_ec_branch(ec->child_ptr[1], label, jump_if);
                 } else {
-                        yyerror("system err: EC_PARAMETER_LIST");
+                        const int32_t skip_label = cur_label_index_head++;
+
+                        translate_ec_branch(ec->child_ptr[0], skip_label, jump_on_either);
+                        translate_ec_branch(ec->child_ptr[1], label, jump_if);
+
+                        stack_cache_flush();
+                        pA("LB(0, %d);", skip_label);
                 }
-        } else if (ec->type_expression == EC_PARAMETER_DECLARATION) {
-                const int32_t old_windoffset = windoffset;
-                cur_declaration_specifiers = ec->var->type | TYPE_WIND;
+
+                return;
+        }
+
+        if (ec->type_expression == EC_CALC && ec->type_operator < EC_TYPE_OPERATOR_LEN &&
+            translate_ec_compare_ope[ec->type_operator] != NULL) {
                 translate_ec(ec->child_ptr[0]);
-                *(ec->var) = *(ec->child_ptr[0]->var);
+                translate_ec(ec->child_ptr[1]);
 
-                windoffset = old_windoffset + ec->var->unit_total_len;
+                const char* ope = (jump_if) ? translate_ec_compare_ope[ec->type_operator] :
+                                              translate_ec_compare_inv_ope[ec->type_operator];
 
-#ifdef DEBUG_EC_PARAMETER_DECLARATION
-                pA_mes("after EC_PARAMETER_DECLARATION, ");
-                pA_mes("\\n");
-                pA_reg("stack_head");
-                pA_mes("\\n");
-                pA_reg("stack_frame");
-                pA_mes("\\n");
-                debug_stackframe(16);
-#endif /* DEBUG_EC_PARAMETER_DECLARATION */
-        } else if (ec->type_expression == EC_STATEMENT) {
-                /* 何もしない */
-        } else if (ec->type_expression == EC_COMPOUND_STATEMENT) {
-                local_varlist_scope_push();   /* コンパイル時 */
-
-                if (ec->child_len == 2) {
-                        translate_ec(ec->child_ptr[0]);
-                        translate_ec(ec->child_ptr[1]);
-                }
+                __var_func_compare_branch(ope, label,
+                                          ec->child_ptr[0]->var, "fixL",
+                                          ec->child_ptr[1]->var, "fixR");
+                return;
+        }
 
-                local_varlist_scope_pop();    /* コンパイル時 */
-        } else if (ec->type_expression == EC_LABELED_STATEMENT) {
-                pA("LB(1, %d);", labellist_search(ec->var->iden));
-        } else if (ec->type_expression == EC_EXPRESSION_STATEMENT) {
-                if (ec->child_len != 0) {
-                        /* As for the statement to belong to expression,
-                         * push may be left in the stack on end of time.
-                         * When a push to stack is left, We clean it.
-                         */
-                        var_read_value_dummy(ec->child_ptr[0]->var);
-                }
-        } else if (ec->type_expression == EC_STATEMENT_LIST) {
-                /* 何もしない */
-        } else if (ec->type_expression == EC_SELECTION_STATEMENT) {
-                if (ec->type_operator == EC_OPE_IF) {
-                        translate_ec(ec->child_ptr[0]);
+        /* それ以外の式は値を求めてから 0 と比較する */
+        translate_ec(ec);
+        var_realize_read_value(ec->var, "stack_socket");
+        stack_cache_flush();
+        pA("if (stack_socket %s 0) {PLIMM(P3F, %d);}", (jump_if) ? "!=" : "==", label);
+}
 
-                        const int32_t else_label = cur_label_index_head++;
-                        const int32_t end_label = cur_label_index_head++;
+/* EC_SELECTION_STATEMENT, EC_OPE_IF: if (else) 文
+ */
+static void translate_ec_if(struct EC* ec)
+{
+        const int32_t else_label = cur_label_index_head++;
+        const int32_t end_label = cur_label_index_head++;
 
-                        var_realize_read_value(ec->child_ptr[0]->var, "stack_socket");
-                        pA("if (stack_socket == 0) {PLIMM(P3F, %d);}", else_label);
+        translate_ec_branch(ec->child_ptr[0], else_label, 0);
 
-                        translate_ec(ec->child_ptr[1]);
+        translate_ec(ec->child_ptr[1]);
 
-                        pA("PLIMM(P3F, %d);", end_label);
-                        pA("LB(0, %d);", else_label);
+        stack_cache_flush();
+        pA("PLIMM(P3F, %d);", end_label);
+        pA("LB(0, %d);", else_label);
 
-                        if (ec->child_len == 3)
-                                translate_ec(ec->child_ptr[2]);
+        if (ec->child_len == 3)
+                translate_ec(ec->child_ptr[2]);
 
-                        pA("LB(0, %d);", end_label);
-                } else {
-                        yyerror("system err: translate_ec(), EC_SELECTION_STATEMENT");
-                }
-        } else if (ec->type_expression == EC_ITERATION_STATEMENT) {
-                if (ec->type_operator == EC_OPE_WHILE) {
-                        const int32_t loop_head = cur_label_index_head++;
-                        const int32_t loop_end = cur_label_index_head++;
+        stack_cache_flush();
+        pA("LB(0, %d);", end_label);
+}
+
+/* EC_ITERATION_STATEMENT, EC_OPE_WHILE: while 文
+ */
+static void translate_ec_while(struct EC* ec)
+{
+        const int32_t loop_head = cur_label_index_head++;
+        const int32_t loop_end = cur_label_index_head++;
+
+        stack_cache_flush();
+        pA("LB(0, %d);", loop_head);
+
+        translate_ec_branch(ec->child_ptr[0], loop_end, 0);
 
-                        pA("LB(0, %d);", loop_head);
+        translate_ec(ec->child_ptr[1]);
 
-                        translate_ec(ec->child_ptr[0]);
-                        var_realize_read_value(ec->child_ptr[0]->var, "stack_socket");
-                        pA("if (stack_socket == 0) {PLIMM(P3F, %d);}", loop_end);
+        stack_cache_flush();
+        pA("PLIMM(P3F, %d);", loop_head);
 
-                        translate_ec(ec->child_ptr[1]);
+        pA("LB(0, %d);", loop_end);
+}
 
-                        pA("PLIMM(P3F, %d);", loop_head);
+/* EC_ITERATION_STATEMENT, EC_OPE_FOR: for 文
+ */
+static void translate_ec_for(struct EC* ec)
+{
+        const int32_t loop_head = cur_label_index_head++;
+        const int32_t loop_end = cur_label_index_head++;
 
-                        pA("LB(0, %d);", loop_end);
-                } else if (ec->type_operator == EC_OPE_FOR) {
-                        const int32_t loop_head = cur_label_index_head++;
-                        const int32_t loop_end = cur_label_index_head++;
+        translate_ec(ec->child_ptr[0]);
+        var_read_value_dummy(ec->child_ptr[0]->var); /* This return a state of stack +1 to 0. */
 
-                        translate_ec(ec->child_ptr[0]);
-                        var_read_value_dummy(ec->child_ptr[0]->var); /* This return a state of stack +1 to 0. */
+        stack_cache_flush();
+        pA("LB(0, %d);", loop_head);
 
-                        pA("LB(0, %d);", loop_head);
+        translate_ec_branch(ec->child_ptr[1], loop_end, 0);
 
-                        translate_ec(ec->child_ptr[1]);
-                        var_realize_read_value(ec->child_ptr[1]->var, "stack_socket");
-                        pA("if (stack_socket == 0) {PLIMM(P3F, %d);}", loop_end);
+        translate_ec(ec->child_ptr[3]);
 
-                        translate_ec(ec->child_ptr[3]);
+        translate_ec(ec->child_ptr[2]);
+        var_read_value_dummy(ec->child_ptr[2]->var); /* This return a state of stack +1 to 0. */
 
-                        translate_ec(ec->child_ptr[2]);
-                        var_read_value_dummy(ec->child_ptr[2]->var); /* This return a state of stack +1 to 0. */
+        stack_cache_flush();
+        pA("PLIMM(P3F, %d);", loop_head);
 
-                        pA("PLIMM(P3F, %d);", loop_head);
+        pA("LB(0, %d);", loop_end);
+}
 
-                        pA("LB(0, %d);", loop_end);
-                } else {
-                        yyerror("system err: translate_ec(), EC_ITERATION_STATEMENT");
-                }
-        } else if (ec->type_expression == EC_JUMP_STATEMENT) {
-                if (ec->type_operator == EC_OPE_GOTO) {
-                        pA("PLIMM(P3F, %d);", labellist_search(ec->var->iden));
-                } else if (ec->type_operator == EC_OPE_RETURN) {
-                        /* In the case of empty return, We operate it as return 0.
-                         * Because the user definition function is expression,
-                         * this has to do stack +1 after the end by all meanes.
-                         */
-                        if (ec->child_len == 0)
-                                pA("fixA = 0;");
-                        else
-                                var_realize_read_value(ec->child_ptr[0]->var, "fixA");
+/* EC_JUMP_STATEMENT, EC_OPE_GOTO: goto 文
+ */
+static void translate_ec_goto(struct EC* ec)
+{
+        stack_cache_flush();
+        pA("PLIMM(P3F, %d);", labellist_search(ec->var->iden));
+}
+
+/* EC_JUMP_STATEMENT, EC_OPE_RETURN: return 文
+ */
+static void translate_ec_return(struct EC* ec)
+{
+        /* In the case of empty return, We operate it as return 0.
+         * Because the user definition function is expression,
+         * this has to do stack +1 after the end by all meanes.
+         */
+        if (ec->child_len == 0)
+                pA("fixA = 0;");
+        else
+                var_realize_read_value(ec->child_ptr[0]->var, "fixA");
 
 #ifdef DEBUG_EC_JUMP_STATEMENT
-                        pA_mes("EC_JUMP_STATEMENT, EC_OPE_RETURN: ");
-                        pA_reg("fixA");
-                        pA_mes("\\n");
+        pA_mes("EC_JUMP_STATEMENT, EC_OPE_RETURN: ");
+        pA_reg("fixA");
+        pA_mes("\\n");
 #endif /* DEBUG_EC_JUMP_STATEMENT */
 
-                        __define_user_function_return();
-                } else {
-                        yyerror("system err: translate_ec(), EC_JUMP_STATEMENT");
-                }
-        } else if (ec->type_expression == EC_INLINE_ASSEMBLER_STATEMENT) {
-                if (ec->type_operator == EC_OPE_ASM_STATEMENT) {
-                        pA("%s", (char*)ec->var->const_variable);
-                } else if (ec->type_operator == EC_OPE_ASM_SUBST_VTOR) {
-                        translate_ec(ec->child_ptr[0]);
-                        const char* tmp = (char*)ec->var->const_variable;
+        __define_user_function_return();
+}
+
+/* EC_INLINE_ASSEMBLER_STATEMENT, EC_OPE_ASM_STATEMENT: アセンブラ命令リスト
+ */
+static void translate_ec_asm_statement(struct EC* ec)
+{
+        /* アセンブラ命令が用いるレジスターは分からないので、スタックのレジスター上の要素は書き出しておく */
+        stack_cache_flush();
+        pA("%s", (char*)ec->var->const_variable);
+}
+
+/* EC_INLINE_ASSEMBLER_STATEMENT, EC_OPE_ASM_SUBST_VTOR: 変数からレジスターへの代入
+ */
+static void translate_ec_asm_subst_vtor(struct EC* ec)
+{
+        translate_ec(ec->child_ptr[0]);
+        const char* tmp = (char*)ec->var->const_variable;
 
 #ifdef DEBUG_EC_INLINE_ASSEMBLER_STATEMENT
-                        var_print(ec->child_ptr[0]->var);
-                        pA_mes("INLINE ARRAY\\n");
+        var_print(ec->child_ptr[0]->var);
+        pA_mes("INLINE ARRAY\\n");
 #endif /* DEBUG_EC_INLINE_ASSEMBLER_STATEMENT */
 
-                        var_realize_read_value(ec->child_ptr[0]->var, tmp);
-                } else if (ec->type_operator == EC_OPE_ASM_SUBST_RTOV) {
-                        translate_ec(ec->child_ptr[0]);
-                        const char* tmp = (char*)ec->var->const_variable;
-
-                        if (ec->child_ptr[0]->var->is_lvalue) {
-                                var_pre_read_value(ec->child_ptr[0]->var, "stack_socket");
-                                write_mem(tmp, "stack_socket");
-                        } else {
-                                yyerror("syntax err: 有効な左辺値ではありません");
-                        }
-                } else {
-                        yyerror("system err: translate_ec(), EC_INLINE_ASSEMBLER_STATEMENT");
-                }
-        } else if (ec->type_expression == EC_EXPRESSION) {
-                /* 何もしない */
-        } else if (ec->type_expression == EC_ASSIGNMENT) {
-                if (ec->type_operator == EC_OPE_SUBST) {
-                        *(ec->var) = *(__var_func_assignment_new("fixA",
-                                                                 ec->child_ptr[0]->var, "fixL",
-                                                                 ec->child_ptr[1]->var, "fixR"));
-                } else {
-                        yyerror("system err: translate_ec(), EC_ASSIGNMENT");
-                }
-        } else if (ec->type_expression == EC_CALC) {
-                if (ec->type_operator == EC_OPE_ADD) {
-                        ec->var = __var_func_add_new("fixA",
-                                                     ec->child_ptr[0]->var, "fixL",
-                                                     ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_SUB) {
-                        ec->var = __var_func_sub_new("fixA",
-                                                     ec->child_ptr[0]->var, "fixL",
-                                                     ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_MUL) {
-                        ec->var = __var_func_mul_new("fixA",
-                                                     ec->child_ptr[0]->var, "fixL",
-                                                     ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_DIV) {
-                        ec->var = __var_func_div_new("fixA",
-                                                     ec->child_ptr[0]->var, "fixL",
-                                                     ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_MOD) {
-                        ec->var = __var_func_mod_new("fixA",
-                                                     ec->child_ptr[0]->var, "fixL",
-                                                     ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_OR) {
-                        ec->var = __var_func_or_new("fixA",
-                                                    ec->child_ptr[0]->var, "fixL",
-                                                    ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_AND) {
-                        ec->var = __var_func_and_new("fixA",
-                                                     ec->child_ptr[0]->var, "fixL",
-                                                     ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_XOR) {
-                        ec->var = __var_func_xor_new("fixA",
+        var_realize_read_value(ec->child_ptr[0]->var, tmp);
+}
+
+/* EC_INLINE_ASSEMBLER_STATEMENT, EC_OPE_ASM_SUBST_RTOV: レジスターから変数への代入
+ */
+static void translate_ec_asm_subst_rtov(struct EC* ec)
+{
+        translate_ec(ec->child_ptr[0]);
+        const char* tmp = (char*)ec->var->const_variable;
+
+        if (var_is_register(ec->child_ptr[0]->var)) {
+                pA("%s = %s;", var_register_name(ec->child_ptr[0]->var), tmp);
+        } else if (ec->child_ptr[0]->var->is_lvalue) {
+                var_pre_read_value(ec->child_ptr[0]->var, "stack_socket");
+                write_mem(tmp, "stack_socket");
+        } else {
+                yyerror("syntax err: 有効な左辺値ではありません");
+        }
+}
+
+/* EC_ASSIGNMENT, EC_OPE_SUBST: 代入
+ */
+static void translate_ec_subst(struct EC* ec)
+{
+        var_copy(ec->var, __var_func_assignment_new("fixA",
                                                      ec->child_ptr[0]->var, "fixL",
-                                                     ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_LSHIFT) {
-                        ec->var = __var_func_lshift_new("fixA",
-                                                        ec->child_ptr[0]->var, "fixL",
-                                                        ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_RSHIFT) {
-                        ec->var = __var_func_rshift_new("fixA",
-                                                        ec->child_ptr[0]->var, "fixL",
-                                                        ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_EQ) {
-                        ec->var = __var_func_eq_new("fixA",
-                                                    ec->child_ptr[0]->var, "fixL",
-                                                    ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_NE) {
-                        ec->var = __var_func_ne_new("fixA",
-                                                    ec->child_ptr[0]->var, "fixL",
-                                                    ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_LT) {
-                        ec->var = __var_func_lt_new("fixA",
-                                                    ec->child_ptr[0]->var, "fixL",
-                                                    ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_LE) {
-                        ec->var = __var_func_le_new("fixA",
-                                                    ec->child_ptr[0]->var, "fixL",
-                                                    ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_GT) {
-                        ec->var = __var_func_gt_new("fixA",
-                                                    ec->child_ptr[0]->var, "fixL",
-                                                    ec->child_ptr[1]->var, "fixR");
-                } else if (ec->type_operator == EC_OPE_GE) {
-                        ec->var = __var_func_ge_new("fixA",
-                                                    ec->child_ptr[0]->var, "fixL",
-                                                    ec->child_ptr[1]->var, "fixR");
-                } else {
-                        yyerror("system err: translate_ec(), EC_CALC");
-                }
-        } else if (ec->type_expression == EC_CAST) {
-                translate_ec(ec->child_ptr[0]);
+                                                     ec->child_ptr[1]->var, "fixR"));
+}
 
-                ec->child_ptr[0]->var = var_normalization_type(ec->child_ptr[0]->var);
-                ec->var = var_normalization_type(ec->var);
+/* EC_CALC の二項演算の処理。 type_operator で引く */
+typedef struct Var* (*translate_ec_calc_func)(const char* areg,
+                                              struct Var* lvar, const char* lreg,
+                                              struct Var* rvar, const char* rreg);
+
+static const translate_ec_calc_func translate_ec_calc_table[EC_TYPE_OPERATOR_LEN] = {
+        [EC_OPE_ADD]    = __var_func_add_new,
+        [EC_OPE_SUB]    = __var_func_sub_new,
+        [EC_OPE_MUL]    = __var_func_mul_new,
+        [EC_OPE_DIV]    = __var_func_div_new,
+        [EC_OPE_MOD]    = __var_func_mod_new,
+        [EC_OPE_OR]     = __var_func_or_new,
+        [EC_OPE_AND]    = __var_func_and_new,
+        [EC_OPE_XOR]    = __var_func_xor_new,
+        [EC_OPE_LSHIFT] = __var_func_lshift_new,
+        [EC_OPE_RSHIFT] = __var_func_rshift_new,
+        [EC_OPE_EQ]     = __var_func_eq_new,
+        [EC_OPE_NE]     = __var_func_ne_new,
+        [EC_OPE_LT]     = __var_func_lt_new,
+        [EC_OPE_LE]     = __var_func_le_new,
+        [EC_OPE_GT]     = __var_func_gt_new,
+        [EC_OPE_GE]     = __var_func_ge_new,
+};
+
+/* EC_CALC: 二項演算
+ */
+static void translate_ec_calc(struct EC* ec)
+{
+        if (ec->type_operator >= EC_TYPE_OPERATOR_LEN ||
+            translate_ec_calc_table[ec->type_operator] == NULL)
+                yyerror("system err: translate_ec(), EC_CALC");
 
-                var_realize_read_value(ec->child_ptr[0]->var, "stack_socket");
-                cast_regval(ec->var, ec->child_ptr[0]->var, "stack_socket");
-                push_stack("stack_socket");
+        ec->var = translate_ec_calc_table[ec->type_operator]("fixA",
+                                                            ec->child_ptr[0]->var, "fixL",
+                                                            ec->child_ptr[1]->var, "fixR");
+}
 
-                /* We assume it the RValue which is in condition that
-                 * an value was acquired in stack.
-                 */
-                ec->var->base_ptr = -1;
-                ec->var->is_lvalue = 0;
-        } else if (ec->type_expression == EC_PRIMARY) {
-                if (ec->type_operator == EC_OPE_VARIABLE) {
-                        struct Var* tmp = varlist_search(ec->var->iden);
-                        if (tmp == NULL) {
-                                printf("[%s]\n", ec->var->iden);
-                                yyerror("syntax err: 未定義の変数を参照しようとしました");
-                        }
-
-                        *(ec->var) = *tmp;
-                } else {
-                        yyerror("system err: translate_ec(), EC_PRIMARY");
-                }
-        } else if (ec->type_expression == EC_UNARY) {
-                if (ec->type_operator == EC_OPE_ADDRESS) {
-                        *(ec->var) = *(ec->child_ptr[0]->var);
+/* EC_CALC, EC_OPE_LOGICAL_{AND,OR}: &&, || の値
+ * 条件分岐と同じく短絡評価して、結果の 1 または 0 をスタックへ積む。
+ */
+static void translate_ec_logical(struct EC* ec)
+{
+        const int32_t false_label = cur_label_index_head++;
+        const int32_t end_label = cur_label_index_head++;
+
+        translate_ec_branch(ec, false_label, 0);
+
+        stack_cache_flush();
+        pA("stack_socket = 1;");
+        pA("PLIMM(P3F, %d);", end_label);
+        pA("LB(0, %d);", false_label);
+        pA("stack_socket = 0;");
+        pA("LB(0, %d);", end_label);
+
+        push_stack("stack_socket");
+
+        ec->var->type = TYPE_SIGNED | TYPE_INT;
+        ec->var->unit_total_len = 1;
+        ec->var->base_ptr = -1;
+        ec->var->is_lvalue = 0;
+}
 
-                        if (ec->var->type & TYPE_ARRAY)
-                                ec->var->dim_len = 0;
+/* EC_CAST: 型変換
+ */
+static void translate_ec_cast(struct EC* ec)
+{
+        translate_ec(ec->child_ptr[0]);
+
+        ec->child_ptr[0]->var = var_normalization_type(ec->child_ptr[0]->var);
+        ec->var = var_normalization_type(ec->var);
 
-                        ec->var = var_read_address(ec->var, "stack_socket");
-                        push_stack("stack_socket");
+        var_realize_read_value(ec->child_ptr[0]->var, "stack_socket");
+        cast_regval(ec->var, ec->child_ptr[0]->var, "stack_socket");
+        push_stack("stack_socket");
+
+        /* We assume it the RValue which is in condition that
+         * an value was acquired in stack.
+         */
+        ec->var->base_ptr = -1;
+        ec->var->is_lvalue = 0;
+}
+
+/* EC_PRIMARY, EC_OPE_VARIABLE: 変数の参照
+ */
+static void translate_ec_variable(struct EC* ec)
+{
+        struct Var* tmp = varlist_search(ec->var->iden);
+        if (tmp == NULL) {
+                printf("[%s]\n", ec->var->iden);
+                yyerror("syntax err: 未定義の変数を参照しようとしました");
+        }
 
-                        ec->var->indirect_len++;
+        var_copy(ec->var, tmp);
 
-                        /* This assume it the RValue which is in condition that
-                         * an value was acquired in stack.
-                         */
+        /* --whole-program で書き換えられないと判明したグローバル変数は、メモリーから読まずに初期値の即値とする */
+        if (program_enable) {
+                struct ProgramSymbol* sym = program_symbol_search(ec->var->iden);
+                if (sym != NULL && sym->const_value != NULL) {
+                        var_copy(ec->var, sym->const_value->var);
                         ec->var->base_ptr = -1;
+                        ec->var->unit_total_len = 1;
                         ec->var->is_lvalue = 0;
-
-                        /* Array-Type is Non-Array-Type by address acquisition.
-                         */
-                        ec->var->type &= ~TYPE_ARRAY;
-                        ec->var->dim_len = var_get_type_to_size(ec->var);
-                } else if (ec->type_operator == EC_OPE_POINTER) {
-                        *(ec->var) = *(ec->child_ptr[0]->var);
-
-                        var_indirect_pre_read_value(ec->var, "stack_socket");
-                        push_stack("stack_socket");
-                } else if (ec->type_operator == EC_OPE_INV) {
-                        ec->var = __var_func_invert_new("fixA",
-                                                        ec->child_ptr[0]->var, "fixL");
-                } else if (ec->type_operator == EC_OPE_NOT) {
-                        ec->var = __var_func_not_new("fixA",
-                                                     ec->child_ptr[0]->var, "fixL");
-                } else if (ec->type_operator == EC_OPE_SUB) {
-                        ec->var = __var_func_minus_new("fixA",
-                                                       ec->child_ptr[0]->var, "fixL");
-                } else if (ec->type_operator == EC_OPE_SIZEOF) {
-                        ec->var = ec->child_ptr[0]->var;
-                        var_normalization_type(ec->var);
-                        const int32_t type_size = var_get_type_to_size(ec->var);
-                        const int32_t total_size = ec->var->unit_total_len * type_size;
-                        pA("stack_socket = %d;", total_size);
-                        push_stack("stack_socket");
-                } else {
-                        yyerror("system err: translate_ec(), EC_UNARY");
+                        report_count.program_const_propagate++;
                 }
-        } else if (ec->type_expression == EC_POSTFIX) {
-                if (ec->type_operator == EC_OPE_ARRAY) {
-                        if (ec->child_ptr[0]->var->type & TYPE_ARRAY) {
-                                if (ec->child_ptr[0]->var->dim_len <= 0)
-                                        yyerror("syntax err: 配列の添字次元が不正です");
-
-                                var_realize_read_value(ec->child_ptr[1]->var, "stack_socket");
-                                *(ec->var) = *(var_pre_read_value(ec->child_ptr[0]->var, "stack_socket"));
-                                push_stack("stack_socket");
-                        } else if (ec->child_ptr[0]->var->indirect_len >= 1) {
-                                ec->var = __var_func_add_new("fixA",
-                                                             ec->child_ptr[0]->var, "fixL",
-                                                             ec->child_ptr[1]->var, "fixR");
-
-                                ec->var = var_indirect_pre_read_value(ec->var, "stack_socket");
-                                push_stack("stack_socket");
-                        } else {
-                                yyerror("syntax err: 非ポインター型スカラー変数への添字によるアクセスは不正です");
-                        }
-                } else if (ec->type_operator == EC_OPE_FUNCTION) {
+        }
+}
+
+/* EC_UNARY, EC_OPE_ADDRESS: & によるアドレス取得
+ */
+static void translate_ec_address(struct EC* ec)
+{
+        var_copy(ec->var, ec->child_ptr[0]->var);
+
+        if (ec->var->type & TYPE_ARRAY)
+                ec->var->dim_len = 0;
+
+        ec->var = var_read_address(ec->var, "stack_socket");
+        push_stack("stack_socket");
+
+        ec->var->indirect_len++;
+
+        /* This assume it the RValue which is in condition that
+         * an value was acquired in stack.
+         */
+        ec->var->base_ptr = -1;
+        ec->var->is_lvalue = 0;
+
+        /* Array-Type is Non-Array-Type by address acquisition.
+         */
+        ec->var->type &= ~TYPE_ARRAY;
+        ec->var->dim_len = var_get_type_to_size(ec->var);
+}
+
+/* EC_UNARY, EC_OPE_POINTER: ポインター * によるアクセス
+ */
+static void translate_ec_pointer(struct EC* ec)
+{
+        var_copy(ec->var, ec->child_ptr[0]->var);
+
+        var_indirect_pre_read_value(ec->var, "stack_socket");
+        push_stack("stack_socket");
+}
+
+/* EC_UNARY, EC_OPE_SIZEOF: sizeof
+ */
+static void translate_ec_sizeof(struct EC* ec)
+{
+        ec->var = ec->child_ptr[0]->var;
+        ec->var->type &= ~TYPE_LITERAL; /* 結果はスタックに積むので、即値ではない */
+        var_normalization_type(ec->var);
+        const int32_t type_size = var_get_type_to_size(ec->var);
+        const int32_t total_size = ec->var->unit_total_len * type_size;
+        pA("stack_socket = %d;", total_size);
+        push_stack("stack_socket");
+}
+
+/* EC_UNARY の単項演算の処理。 type_operator で引く */
+typedef struct Var* (*translate_ec_unary_func)(const char* areg,
+                                               struct Var* lvar, const char* lreg);
+
+static const translate_ec_unary_func translate_ec_unary_table[EC_TYPE_OPERATOR_LEN] = {
+        [EC_OPE_INV] = __var_func_invert_new,
+        [EC_OPE_NOT] = __var_func_not_new,
+        [EC_OPE_SUB] = __var_func_minus_new,
+};
+
+/* EC_UNARY, EC_OPE_{INV,NOT,SUB}: ~, !, - による単項演算
+ */
+static void translate_ec_unary(struct EC* ec)
+{
+        ec->var = translate_ec_unary_table[ec->type_operator]("fixA",
+                                                             ec->child_ptr[0]->var, "fixL");
+}
+
+/* EC_POSTFIX, EC_OPE_ARRAY: [] による配列アクセス
+ */
+static void translate_ec_array(struct EC* ec)
+{
+        if (ec->child_ptr[0]->var->type & TYPE_ARRAY) {
+                if (ec->child_ptr[0]->var->dim_len <= 0)
+                        yyerror("syntax err: 配列の添字次元が不正です");
+
+                var_realize_read_value(ec->child_ptr[1]->var, "stack_socket");
+                var_copy(ec->var, var_pre_read_value(ec->child_ptr[0]->var, "stack_socket"));
+                push_stack("stack_socket");
+        } else if (ec->child_ptr[0]->var->indirect_len >= 1) {
+                ec->var = __var_func_add_new("fixA",
+                                             ec->child_ptr[0]->var, "fixL",
+                                             ec->child_ptr[1]->var, "fixR");
+
+                ec->var = var_indirect_pre_read_value(ec->var, "stack_socket");
+                push_stack("stack_socket");
+        } else {
+                yyerror("syntax err: 非ポインター型スカラー変数への添字によるアクセスは不正です");
+        }
+}
+
+/* EC_POSTFIX, EC_OPE_FUNCTION: f() による関数コール
+ */
+static void translate_ec_function_call(struct EC* ec)
+{
 #ifdef DEBUG_EC_OPE_FUNCTION
-                        pA_mes("before OPE_FUNCTION, ");
-                        pA_mes("\\n");
-                        pA_reg("stack_frame");
-                        pA_mes("\\n");
-                        pA_reg("stack_head");
-                        pA_mes("\\n");
-                        debug_stackframe(16);
+        pA_mes("before OPE_FUNCTION, ");
+        pA_mes("\\n");
+        pA_reg("stack_frame");
+        pA_mes("\\n");
+        pA_reg("stack_head");
+        pA_mes("\\n");
+        debug_stackframe(16);
 #endif /* DEBUG_EC_OPE_FUNCTION */
 
-                        /* This push to the stack position at time of the function
-                         * call to call stack.
-                         */
-                        push_callstack("stack_head");
-
-                        struct Var* var = global_varlist_search(ec->var->iden);
-                        if (var == NULL)
-                                yyerror("syntax err: 未定義の関数を呼び出そうとしました");
-
-                        translate_ec(ec->child_ptr[0]);
-
-                        /* This push current Stack-Frame.
-                         * And We set Stack-Head of the point time when We
-                         * acquired a function argument in stack to
-                         * Stack-Frame.
-                         */
-                        push_stackframe("stack_head");
-
-                        const int32_t return_label = cur_label_index_head++;
-                        pA("PLIMM(labelstack_socket, %d);", return_label);
-                        push_labelstack();
-
-                        pA("PLIMM(P3F, %d);", var->base_ptr);
-                        pA("LB(1, %d);", return_label);
-
-                        /* EC_OPE_FUNCTION is Return-Value after here.
-                         * Because return variable is stack variable, it is a
-                         * RValue. Because it is a RValue, We assumes it
-                         * base_ptr = -1.
-                         */
-                        ec->var->type = cur_declaration_specifiers;
-                        ec->var->base_ptr = -1;
-                        ec->var->is_lvalue = 0;
+        /* This push to the stack position at time of the function
+         * call to call stack.
+         * 呼び出し先もスタックのレジスターを用いるので、ここまでの要素はメモリーへ書き出しておく。
+         */
+        stack_cache_flush();
+        var_register_save();
+        push_callstack("stack_head");
+
+        struct Var* var = global_varlist_search(ec->var->iden);
+        if (var == NULL)
+                yyerror("syntax err: 未定義の関数を呼び出そうとしました");
+
+        translate_ec(ec->child_ptr[0]);
+
+        /* This push current Stack-Frame.
+         * And We set Stack-Head of the point time when We
+         * acquired a function argument in stack to
+         * Stack-Frame.
+         * 引数は呼び出し先が stack_frame から参照するので、メモリーへ書き出しておく。
+         */
+        stack_cache_flush();
+        push_stackframe("stack_head");
+
+        const int32_t return_label = cur_label_index_head++;
+        pA("PLIMM(labelstack_socket, %d);", return_label);
+        push_labelstack();
+
+        pA("PLIMM(P3F, %d);", var->base_ptr);
+        pA("LB(1, %d);", return_label);
+
+        var_register_restore();
+
+        /* EC_OPE_FUNCTION is Return-Value after here.
+         * Because return variable is stack variable, it is a
+         * RValue. Because it is a RValue, We assumes it
+         * base_ptr = -1.
+         */
+        ec->var->type = cur_declaration_specifiers;
+        ec->var->base_ptr = -1;
+        ec->var->is_lvalue = 0;
 
 #ifdef DEBUG_EC_OPE_FUNCTION
-                        pA_mes("after OPE_FUNCTION, ");
-                        pA_mes("\\n");
-                        pA_reg("stack_frame");
-                        pA_mes("\\n");
-                        pA_reg("stack_head");
-                        pA_mes("\\n");
-                        debug_stackframe(16);
+        pA_mes("after OPE_FUNCTION, ");
+        pA_mes("\\n");
+        pA_reg("stack_frame");
+        pA_mes("\\n");
+        pA_reg("stack_head");
+        pA_mes("\\n");
+        debug_stackframe(16);
 #endif /* DEBUG_EC_OPE_FUNCTION */
-                } else {
-                        yyerror("system err: translate_ec(), EC_POSTFIX");
-                }
-        } else if (ec->type_expression == EC_ARGUMENT_EXPRESSION_LIST) {
-                if (ec->child_len >= 1) {
-                        translate_ec(ec->child_ptr[0]);
-                        *(ec->var) = *(ec->child_ptr[0]->var);
+}
+
+/* EC_ARGUMENT_EXPRESSION_LIST: 関数コール時の引数リスト
+ */
+static void translate_ec_argument_expression_list(struct EC* ec)
+{
+        if (ec->child_len >= 1) {
+                translate_ec(ec->child_ptr[0]);
+                var_copy(ec->var, ec->child_ptr[0]->var);
 
-                        var_realize_read_value(ec->var, "stack_socket");
-                        push_stack("stack_socket");
+                var_realize_read_value(ec->var, "stack_socket");
+                push_stack("stack_socket");
 
 #ifdef DEBUG_EC_ARGUMENT_EXPRESSION_LIST
-                        pA_mes("after EC_ARGUMENT_EXPRESSION_LIST, ");
-                        pA_mes("\\n");
-                        pA_reg("stack_frame");
-                        pA_mes("\\n");
-                        pA_reg("stack_head");
-                        pA_mes("\\n");
-                        debug_stackframe(16);
+                pA_mes("after EC_ARGUMENT_EXPRESSION_LIST, ");
+                pA_mes("\\n");
+                pA_reg("stack_frame");
+                pA_mes("\\n");
+                pA_reg("stack_head");
+                pA_mes("\\n");
+                debug_stackframe(16);
 #endif /* DEBUG_EC_ARGUMENT_EXPRESSION_LIST */
-                }
+        }
 
-                if (ec->child_len == 2)
-                        translate_ec(ec->child_ptr[1]);
+        if (ec->child_len == 2)
+                translate_ec(ec->child_ptr[1]);
+}
 
-        } else if (ec->type_expression == EC_CONSTANT) {
-                /* Adding a constant setting process on the upper side of the
-                 * file by using the pB(). if an undefined constant.
-                 */
-                struct Var* tmp = global_varlist_search(ec->var->iden);
-                if (tmp == NULL) {
-                        tmp = var_initializer_new(ec->var, ec->var->type);
-                        if (tmp == NULL)
-                                yyerror("system err: EC_CONSTANT, new_var_initializer_new()");
-
-                        /* const_variable because it is not recorded in
-                         * var_initializer_new()
-                         */
-                        pB("stack_socket = %d;", *((int*)(ec->var->const_variable)));
-
-                        /* To write a value to a position to store the value.
-                         */
-                        pB("stack_tmp = %d;", tmp->base_ptr);
-                        write_mem_pB("stack_socket", "stack_tmp");
-                }
+/* EC_CONSTANT: 定数
+ * 定数はメモリーにもスタックにも置かず、即値として扱う。
+ * 値は const_variable に保持されており、読み込む時点で var_pre_read_value() がレジスターへ直接セットする。
+ */
+static void translate_ec_constant(struct EC* ec)
+{
+        ec->var->base_ptr = -1;
+        ec->var->unit_total_len = 1;
+        ec->var->is_lvalue = 0;
 
-                /* Because constant should be defined always at this point.
-                 */
-                tmp = global_varlist_search(ec->var->iden);
-                if (tmp == NULL)
-                        yyerror("system err: EC_CONSTANT");
+        if (!var_is_immediate(ec->var))
+                yyerror("system err: EC_CONSTANT");
+}
 
-                *(ec->var) = *tmp;
-        } else {
+/* EC 種類毎の翻訳処理の表
+ *
+ * func: この EC の翻訳処理
+ * translate_children: 1 であれば func の前に child_ptr[] の全ての子を順に翻訳し、child_ptr[0] の var を自身の var へコピーする。
+ *                     0 であれば子の翻訳は func 自身が行う。
+ * ope_table: NULL でなければ、さらに type_operator で ope_table[] から翻訳処理を引く。（func, translate_children は用いない）
+ * name: エラー表示用の EC 種類名
+ */
+typedef void (*translate_ec_func)(struct EC* ec);
+
+struct TranslateEC {
+        translate_ec_func func;
+        int32_t translate_children;
+        const struct TranslateEC* ope_table;
+        const char* name;
+};
+
+static const struct TranslateEC translate_ec_selection_table[EC_TYPE_OPERATOR_LEN] = {
+        [EC_OPE_IF]     = {translate_ec_if, 0},
+};
+
+static const struct TranslateEC translate_ec_iteration_table[EC_TYPE_OPERATOR_LEN] = {
+        [EC_OPE_WHILE]  = {translate_ec_while, 0},
+        [EC_OPE_FOR]    = {translate_ec_for, 0},
+};
+
+static const struct TranslateEC translate_ec_jump_table[EC_TYPE_OPERATOR_LEN] = {
+        [EC_OPE_GOTO]   = {translate_ec_goto, 1},
+        [EC_OPE_RETURN] = {translate_ec_return, 1},
+};
+
+static const struct TranslateEC translate_ec_inline_assembler_table[EC_TYPE_OPERATOR_LEN] = {
+        [EC_OPE_ASM_STATEMENT]  = {translate_ec_asm_statement, 0},
+        [EC_OPE_ASM_SUBST_VTOR] = {translate_ec_asm_subst_vtor, 0},
+        [EC_OPE_ASM_SUBST_RTOV] = {translate_ec_asm_subst_rtov, 0},
+};
+
+static const struct TranslateEC translate_ec_assignment_table[EC_TYPE_OPERATOR_LEN] = {
+        [EC_OPE_SUBST]  = {translate_ec_subst, 1},
+};
+
+static const struct TranslateEC translate_ec_primary_table[EC_TYPE_OPERATOR_LEN] = {
+        [EC_OPE_VARIABLE] = {translate_ec_variable, 1},
+};
+
+static const struct TranslateEC translate_ec_unary_ope_table[EC_TYPE_OPERATOR_LEN] = {
+        [EC_OPE_ADDRESS] = {translate_ec_address, 1},
+        [EC_OPE_POINTER] = {translate_ec_pointer, 1},
+        [EC_OPE_INV]     = {translate_ec_unary, 1},
+        [EC_OPE_NOT]     = {translate_ec_unary, 1},
+        [EC_OPE_SUB]     = {translate_ec_unary, 1},
+        [EC_OPE_SIZEOF]  = {translate_ec_sizeof, 1},
+};
+
+static const struct TranslateEC translate_ec_calc_ope_table[EC_TYPE_OPERATOR_LEN] = {
+        [EC_OPE_ADD]            = {translate_ec_calc, 1},
+        [EC_OPE_SUB]            = {translate_ec_calc, 1},
+        [EC_OPE_MUL]            = {translate_ec_calc, 1},
+        [EC_OPE_DIV]            = {translate_ec_calc, 1},
+        [EC_OPE_MOD]            = {translate_ec_calc, 1},
+        [EC_OPE_OR]             = {translate_ec_calc, 1},
+        [EC_OPE_AND]            = {translate_ec_calc, 1},
+        [EC_OPE_XOR]            = {translate_ec_calc, 1},
+        [EC_OPE_LSHIFT]         = {translate_ec_calc, 1},
+        [EC_OPE_RSHIFT]         = {translate_ec_calc, 1},
+        [EC_OPE_EQ]             = {translate_ec_calc, 1},
+        [EC_OPE_NE]             = {translate_ec_calc, 1},
+        [EC_OPE_LT]             = {translate_ec_calc, 1},
+        [EC_OPE_LE]             = {translate_ec_calc, 1},
+        [EC_OPE_GT]             = {translate_ec_calc, 1},
+        [EC_OPE_GE]             = {translate_ec_calc, 1},
+        [EC_OPE_LOGICAL_AND]    = {translate_ec_logical, 0},
+        [EC_OPE_LOGICAL_OR]     = {translate_ec_logical, 0},
+};
+
+static const struct TranslateEC translate_ec_postfix_table[EC_TYPE_OPERATOR_LEN] = {
+        [EC_OPE_ARRAY]    = {translate_ec_array, 1},
+        [EC_OPE_FUNCTION] = {translate_ec_function_call, 0},
+};
+
+static const struct TranslateEC translate_ec_table[EC_TYPE_EXPRESSION_LEN] = {
+        [EC_ASSIGNMENT]                 = {NULL, 0, translate_ec_assignment_table, "EC_ASSIGNMENT"},
+        [EC_CALC]                       = {NULL, 0, translate_ec_calc_ope_table, "EC_CALC"},
+        [EC_UNARY]                      = {NULL, 0, translate_ec_unary_ope_table, "EC_UNARY"},
+        [EC_POSTFIX]                    = {NULL, 0, translate_ec_postfix_table, "EC_POSTFIX"},
+        [EC_PRIMARY]                    = {NULL, 0, translate_ec_primary_table, "EC_PRIMARY"},
+        [EC_CONSTANT]                   = {translate_ec_constant, 1, NULL, "EC_CONSTANT"},
+        [EC_CAST]                       = {translate_ec_cast, 0, NULL, "EC_CAST"},
+        [EC_ARGUMENT_EXPRESSION_LIST]   = {translate_ec_argument_expression_list, 0, NULL, "EC_ARGUMENT_EXPRESSION_LIST"},
+        [EC_EXPRESSION]                 = {translate_ec_nop, 1, NULL, "EC_EXPRESSION"},
+        [EC_EXPRESSION_STATEMENT]       = {translate_ec_expression_statement, 1, NULL, "EC_EXPRESSION_STATEMENT"},
+        [EC_INLINE_ASSEMBLER_STATEMENT] = {NULL, 0, translate_ec_inline_assembler_table, "EC_INLINE_ASSEMBLER_STATEMENT"},
+        [EC_JUMP_STATEMENT]             = {NULL, 0, translate_ec_jump_table, "EC_JUMP_STATEMENT"},
+        [EC_ITERATION_STATEMENT]        = {NULL, 0, translate_ec_iteration_table, "EC_ITERATION_STATEMENT"},
+        [EC_SELECTION_STATEMENT]        = {NULL, 0, translate_ec_selection_table, "EC_SELECTION_STATEMENT"},
+        [EC_COMPOUND_STATEMENT]         = {translate_ec_compound_statement, 0, NULL, "EC_COMPOUND_STATEMENT"},
+        [EC_LABELED_STATEMENT]          = {translate_ec_labeled_statement, 1, NULL, "EC_LABELED_STATEMENT"},
+        [EC_STATEMENT]                  = {translate_ec_nop, 1, NULL, "EC_STATEMENT"},
+        [EC_STATEMENT_LIST]             = {translate_ec_list, 0, NULL, "EC_STATEMENT_LIST"},
+        [EC_DECLARATION]                = {translate_ec_declaration, 0, NULL, "EC_DECLARATION"},
+        [EC_DECLARATION_LIST]           = {translate_ec_list, 0, NULL, "EC_DECLARATION_LIST"},
+        [EC_INIT_DECLARATOR]            = {translate_ec_init_declarator, 1, NULL, "EC_INIT_DECLARATOR"},
+        [EC_INIT_DECLARATOR_LIST]       = {translate_ec_nop, 1, NULL, "EC_INIT_DECLARATOR_LIST"},
+        [EC_DECLARATOR]                 = {translate_ec_declarator, 0, NULL, "EC_DECLARATOR"},
+        [EC_DIRECT_DECLARATOR]          = {translate_ec_nop, 0, NULL, "EC_DIRECT_DECLARATOR"},
+        [EC_PARAMETER_TYPE_LIST]        = {translate_ec_parameter_type_list, 0, NULL, "EC_PARAMETER_TYPE_LIST"},
+        [EC_PARAMETER_LIST]             = {translate_ec_parameter_list, 0, NULL, "EC_PARAMETER_LIST"},
+        [EC_PARAMETER_DECLARATION]      = {translate_ec_parameter_declaration, 0, NULL, "EC_PARAMETER_DECLARATION"},
+        [EC_FUNCTION_DEFINITION]        = {translate_ec_function_definition, 0, NULL, "EC_FUNCTION_DEFINITION"},
+};
+
+/* ec の全ての子を順に翻訳し、child_ptr[0] の var を ec の var へコピーする
+ */
+static void translate_ec_children(struct EC* ec)
+{
+        int32_t i;
+        for (i = 0; i < ec->child_len; i++) {
+                translate_ec(ec->child_ptr[i]);
+        }
+
+        if (ec->child_len >= 1)
+                var_copy(ec->var, ec->child_ptr[0]->var);
+}
+
+/* EC木 ec をアセンブラへ翻訳する
+ * 翻訳処理は translate_ec_table[] を type_expression （必要であればさらに type_operator）で引いて得る。
+ */
+void translate_ec(struct EC* ec)
+{
+        if (ec->type_expression >= EC_TYPE_EXPRESSION_LEN ||
+            translate_ec_table[ec->type_expression].name == NULL)
                 yyerror("system err: translate_ec()");
+
+        const struct TranslateEC* t = translate_ec_table + ec->type_expression;
+
+        if (t->ope_table != NULL) {
+                if (ec->type_operator >= EC_TYPE_OPERATOR_LEN ||
+                    t->ope_table[ec->type_operator].func == NULL) {
+                        char tmp[0x100];
+                        snprintf(tmp, sizeof(tmp), "system err: translate_ec(), %s", t->name);
+                        yyerror(tmp);
+                }
+
+                t = t->ope_table + ec->type_operator;
         }
+
+        /* --whole-program では構文解析の終了後にまとめて翻訳するので、エラー表示用の行番号とファイル名を EC 生成時のものとする。
+         * 通常は構文解析の途中で翻訳するので、字句解析が数えている現在の値は翻訳後に必ず戻す。
+         */
+        const int32_t old_linenumber = linenumber;
+        const char* old_filepath = filepath;
+        linenumber = ec->linenumber;
+        filepath = ec->filepath;
+
+        if (t->translate_children)
+                translate_ec_children(ec);
+
+        t->func(ec);
+
+        linenumber = old_linenumber;
+        filepath = old_filepath;
 }
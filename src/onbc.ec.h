@@ -39,6 +39,8 @@
 #define EC_PARAMETER_DECLARATION 31     /* 関数引数の宣言命令単位 */
 #define EC_FUNCTION_DEFINITION  32      /* 関数定義 */
 
+#define EC_TYPE_EXPRESSION_LEN  33      /* 演算種類のフラグの上限（translate_ec() の表の大きさ） */
+
 /* EC の演算子を示すフラグ
  */
 #define EC_OPE_MUL              1
@@ -83,6 +85,8 @@
 #define EC_OPE_DO_WHILE         40
 #define EC_OPE_FOR              41
 
+#define EC_TYPE_OPERATOR_LEN    42      /* 演算子のフラグの上限（translate_ec() の表の大きさ） */
+
 /* EC (ExpressionContainer)
  * 構文解析の expression_statement 以下から終端記号までの情報を保持するためのコンテナ
  *
@@ -90,6 +94,11 @@
  * type_expression: 演算種類
  * child_ptr[]: この EC をルートとして広がる枝ECへのポインター
  * child_len: child_ptr[] に登録されている枝の数
+ * next: リスト中の次の EC
+ * linenumber, filepath: この EC を生成した時点のソースの行番号とファイル名（翻訳時のエラー表示用）
+ *
+ * EC_STATEMENT_LIST, EC_DECLARATION_LIST は、要素を木として持つと長いリストでは変換時の再帰が深くなるので、
+ * ec_list_append() で child_ptr[0] を先頭、child_ptr[1] を末尾として、各要素の next で連ねる。
  */
 struct EC {
         struct Var* var;
@@ -97,10 +106,15 @@ struct EC {
         uint32_t type_expression;
         struct EC* child_ptr[4];
         int32_t child_len;
+        struct EC* next;
+        int32_t linenumber;
+        const char* filepath;
 };
 
+void init_ec(void);
 struct EC* new_ec(void);
 void delete_ec(struct EC* ec);
+void ec_list_append(struct EC* list, struct EC* item);
 void translate_ec(struct EC* ec);
 
 #endif /* __ONBC_EC_H__ */
@@ -0,0 +1,261 @@
+/* onbc.file.c
+ * Copyright (C) 2013 Takeutch Kemeco
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "onbc.print.h"
+#include "onbc.hash.h"
+#include "onbc.file.h"
+
+/* ソースファイルのキャッシュ
+ *
+ * #include されたファイル（およびルートファイル）は、パス名をキーとしてプロセス終了まで保持する。
+ * 同じヘッダーを何度 #include しても、ファイルを開くのは最初の1回のみとなる。
+ * 複数の翻訳単位を並列にコンパイルする場合は全スレッドで共有するので、テーブルの操作は排他制御する。
+ */
+
+#define SOURCE_FILE_TABLE_BUCKET_LEN 0x100
+
+static struct HashTable* source_file_table = NULL;
+static pthread_mutex_t source_file_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* fp の内容を終端まで全て読み出し、malloc() したバッファーで返す。（*len には長さがセットされる）
+ * パイプや標準入力からも読めるように、サイズは事前に調べずにバッファーを伸ばしながら読む。
+ */
+static char* read_all_fp(FILE* fp, size_t* len)
+{
+        size_t size = 0x1000;
+        char* buf = malloc(size);
+        if (buf == NULL)
+                yyerror("system err: read_all_fp(), malloc()");
+
+        *len = 0;
+        while (1) {
+                *len += fread(buf + *len, 1, size - *len - 1, fp);
+                if (*len < size - 1)
+                        break;
+
+                size *= 2;
+                buf = realloc(buf, size);
+                if (buf == NULL)
+                        yyerror("system err: read_all_fp(), realloc()");
+        }
+
+        buf[*len] = '\0';
+        return buf;
+}
+
+/* 空白、改行、コメントを読み飛ばす
+ */
+static const char* skip_blank(const char* p)
+{
+        while (1) {
+                if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+                        p++;
+                } else if (p[0] == '/' && p[1] == '/') {
+                        while (*p != '\0' && *p != '\n')
+                                p++;
+                } else if (p[0] == '/' && p[1] == '*') {
+                        const char* tail = strstr(p + 2, "*/");
+                        if (tail == NULL)
+                                return p;
+
+                        p = tail + 2;
+                } else {
+                        return p;
+                }
+        }
+}
+
+static int32_t match_word(const char* p, const char* word)
+{
+        return strncmp(p, word, strlen(word)) == 0;
+}
+
+/* buf 全体が #ifndef X ... #endif で囲まれていれば、X を malloc() した文字列で返す。
+ * そうでなければ NULL を返す。
+ *
+ * flex 側の #ifdef スキップ (pre_process_ifdef_skip) はコメントや文字列を区別せずに
+ * #ifdef, #ifndef, #endif の出現を数えるので、ここでも同じ数え方をする。
+ * これにより、X が #define 済みであればファイル全体が読み飛ばされることと、
+ * このファイルを字句解析せずに無視することが等価になる。
+ */
+static char* detect_include_guard(const char* buf)
+{
+        const char* p = skip_blank(buf);
+        if (!match_word(p, "#ifndef"))
+                return NULL;
+
+        p += strlen("#ifndef");
+        while (*p == ' ' || *p == '\t')
+                p++;
+
+        const char* head = p;
+        while (*p == '_' ||
+               (*p >= 'a' && *p <= 'z') ||
+               (*p >= 'A' && *p <= 'Z') ||
+               (p != head && *p >= '0' && *p <= '9'))
+                p++;
+
+        if (p == head)
+                return NULL;
+
+        const size_t iden_len = p - head;
+
+        int32_t depth = 0;
+        int32_t is_closed = 0;
+        while (*p != '\0') {
+                if (match_word(p, "#ifdef")) {
+                        depth++;
+                        p += strlen("#ifdef");
+                } else if (match_word(p, "#ifndef")) {
+                        depth++;
+                        p += strlen("#ifndef");
+                } else if (match_word(p, "#endif")) {
+                        p += strlen("#endif");
+                        if (depth == 0) {
+                                is_closed = 1;
+                                break;
+                        }
+
+                        depth--;
+                } else {
+                        p++;
+                }
+        }
+
+        /* 対応する #endif の後ろに、空白やコメント以外が有ってはならない */
+        if (!is_closed || *skip_blank(p) != '\0')
+                return NULL;
+
+        char* iden = malloc(iden_len + 1);
+        if (iden == NULL)
+                yyerror("system err: detect_include_guard(), malloc()");
+
+        memcpy(iden, head, iden_len);
+        iden[iden_len] = '\0';
+
+        return iden;
+}
+
+/* path のファイルを読み込み、その struct SourceFile を返す。
+ * 既にキャッシュに有れば、ファイルを開かずにそれを返す。
+ * path が "-" の場合は標準入力を読む。
+ *
+ * ファイルが開けなかった場合は NULL を返す。
+ */
+struct SourceFile* source_file_load(const char* path)
+{
+        pthread_mutex_lock(&source_file_mutex);
+
+        if (source_file_table == NULL)
+                source_file_table = new_hash_table(SOURCE_FILE_TABLE_BUCKET_LEN, NULL);
+
+        struct SourceFile* file = hash_table_search(source_file_table, path);
+        if (file != NULL) {
+                pthread_mutex_unlock(&source_file_mutex);
+                return file;
+        }
+
+        FILE* fp = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+        if (fp == NULL) {
+                pthread_mutex_unlock(&source_file_mutex);
+                return NULL;
+        }
+
+        file = malloc(sizeof(*file));
+        if (file == NULL)
+                yyerror("system err: source_file_load(), malloc()");
+
+        file->path = malloc(strlen(path) + 1);
+        if (file->path == NULL)
+                yyerror("system err: source_file_load(), malloc()");
+
+        strcpy(file->path, path);
+        file->buf = read_all_fp(fp, &file->len);
+        file->guard_iden = detect_include_guard(file->buf);
+        file->line_offset = NULL;
+        file->line_len = 0;
+
+        if (fp != stdin)
+                fclose(fp);
+
+        hash_table_insert(source_file_table, path, file);
+
+        pthread_mutex_unlock(&source_file_mutex);
+        return file;
+}
+
+/* file の行の索引 line_offset[] を作成する
+ */
+static void source_file_index_line(struct SourceFile* file)
+{
+        int32_t line_max = 0x100;
+        size_t* line_offset = malloc(sizeof(*line_offset) * line_max);
+        if (line_offset == NULL)
+                yyerror("system err: source_file_index_line(), malloc()");
+
+        int32_t line_len = 0;
+        size_t offset = 0;
+        while (offset < file->len) {
+                if (line_len >= line_max) {
+                        line_max *= 2;
+                        line_offset = realloc(line_offset, sizeof(*line_offset) * line_max);
+                        if (line_offset == NULL)
+                                yyerror("system err: source_file_index_line(), realloc()");
+                }
+
+                line_offset[line_len++] = offset;
+
+                const char* next = memchr(file->buf + offset, '\n', file->len - offset);
+                if (next == NULL)
+                        break;
+
+                offset = next - file->buf + 1;
+        }
+
+        file->line_len = line_len;
+        file->line_offset = line_offset;
+}
+
+/* file の line 行目の先頭アドレスを返し、*len にその行の長さ（改行を含まない）をセットする。
+ * line が 1 未満、または行数を越える場合は NULL を返す。
+ *
+ * 行の索引は最初の呼び出し時に一度だけ作成し、以後はファイルを走査せずに行を得る。
+ */
+const char* source_file_line(struct SourceFile* file, const int32_t line, size_t* len)
+{
+        pthread_mutex_lock(&source_file_mutex);
+        if (file->line_offset == NULL)
+                source_file_index_line(file);
+        pthread_mutex_unlock(&source_file_mutex);
+
+        if (line < 1 || line > file->line_len)
+                return NULL;
+
+        const char* head = file->buf + file->line_offset[line - 1];
+        const char* tail = memchr(head, '\n', file->buf + file->len - head);
+        if (tail == NULL)
+                tail = file->buf + file->len;
+
+        *len = tail - head;
+        return head;
+}
@@ -0,0 +1,31 @@
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef __ONBC_FILE_H__
+#define __ONBC_FILE_H__
+
+/* ソースファイルのキャッシュ関連
+ */
+
+/* メモリー上に読み込んだソースファイル
+ * 一度読み込んだファイルはプロセス終了まで保持し、内容は変更しない。（複数のスレッドから共有される）
+ *
+ * buf: ファイルの内容。末尾には '\0' が付加される。
+ * len: ファイルの内容の長さ（末尾の '\0' は含まない）
+ * guard_iden: ファイル全体が #ifndef X ... #endif で囲まれている場合の X 。それ以外は NULL 。
+ * line_offset[]: 各行の先頭の buf 内での位置（line_offset[0] が1行目）。必要になった時点で作成する。
+ * line_len: line_offset[] の要素数（行数）
+ */
+struct SourceFile {
+        char* path;
+        char* buf;
+        size_t len;
+        char* guard_iden;
+        size_t* line_offset;
+        int32_t line_len;
+};
+
+struct SourceFile* source_file_load(const char* path);
+const char* source_file_line(struct SourceFile* file, const int32_t line, size_t* len);
+
+#endif /* __ONBC_FILE_H__ */
@@ -0,0 +1,364 @@
+/* onbc.fold.c
+ * Copyright (C) 2013 Takeutch Kemeco
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "onbc.print.h"
+#include "onbc.iden.h"
+#include "onbc.var.h"
+#include "onbc.cast.h"
+#include "onbc.ec.h"
+#include "onbc.report.h"
+#include "onbc.arena.h"
+#include "onbc.fold.h"
+
+/* 定数畳み込み
+ *
+ * 子が全て EC_CONSTANT である EC_CALC, EC_UNARY を、コンパイル時に計算して1つの EC_CONSTANT へ置き換える。
+ * 計算結果は、実行時の演算 (onbc.sint.c, onbc.double.c の __func_*()) と同じになるように、
+ * 32bit の符号付き整数、および 1:15:16 の固定小数として、それらと同じ手順で計算する。
+ *
+ * 実行時の結果が処理系の 32bit 演算の細部（0除算、INT32_MIN の符号反転、範囲外のシフトなど）に依存する場合や、
+ * 実行時にエラーとなるべき演算（浮動小数点数型へのビット演算など）は畳み込まずにそのまま残す。
+ */
+
+/* 32bit でラップアラウンドする加算、減算、乗算、符号反転 */
+static int32_t fold_add32(const int32_t a, const int32_t b)
+{
+        return (int32_t)((uint32_t)a + (uint32_t)b);
+}
+
+static int32_t fold_sub32(const int32_t a, const int32_t b)
+{
+        return (int32_t)((uint32_t)a - (uint32_t)b);
+}
+
+static int32_t fold_mul32(const int32_t a, const int32_t b)
+{
+        return (int32_t)((uint32_t)a * (uint32_t)b);
+}
+
+static int32_t fold_neg32(const int32_t a)
+{
+        return (int32_t)(0 - (uint32_t)a);
+}
+
+/* __func_mul_double_module() と同じ手順で l * r を計算する
+ */
+static int32_t fold_mul_double_module(int32_t l, int32_t r)
+{
+        int32_t s = 0;
+        if (l < 0) {l = -l; s |= 1;}
+        if (r < 0) {r = -r; s |= 2;}
+
+        const int32_t rx = (r & 0xffff0000) >> 16;
+        const int32_t lx = (l & 0xffff0000);
+
+        r = r & 0x0000ffff;
+        l = l & 0x0000ffff;
+
+        int32_t a = (((l >> 1) * r) >> 15);
+        a = fold_add32(a, fold_mul32(lx >> 16, r));
+        a = fold_add32(a, fold_mul32(lx, rx));
+        a = fold_add32(a, fold_mul32(l, rx));
+
+        if (s == 1 || s == 2)
+                a = fold_neg32(a);
+
+        return a;
+}
+
+/* sint 同士の二項演算を dst へ計算する。畳み込めない場合は -1 を返す
+ */
+static int32_t fold_binary_sint(int32_t* dst, const uint32_t ope, const int32_t l, const int32_t r)
+{
+        switch (ope) {
+        case EC_OPE_ADD:        *dst = fold_add32(l, r); break;
+        case EC_OPE_SUB:        *dst = fold_sub32(l, r); break;
+        case EC_OPE_MUL:        *dst = fold_mul32(l, r); break;
+        case EC_OPE_AND:        *dst = l & r; break;
+        case EC_OPE_OR:         *dst = l | r; break;
+        case EC_OPE_XOR:        *dst = l ^ r; break;
+        case EC_OPE_EQ:         *dst = (l == r); break;
+        case EC_OPE_NE:         *dst = (l != r); break;
+        case EC_OPE_LT:         *dst = (l < r); break;
+        case EC_OPE_GT:         *dst = (l > r); break;
+        case EC_OPE_LE:         *dst = (l <= r); break;
+        case EC_OPE_GE:         *dst = (l >= r); break;
+
+        case EC_OPE_DIV:
+        case EC_OPE_MOD:
+                if (r == 0 || (l == INT32_MIN && r == -1))
+                        return -1;
+
+                *dst = (ope == EC_OPE_DIV) ? l / r : l % r;
+                break;
+
+        case EC_OPE_LSHIFT:
+                if (r < 0 || r >= 32)
+                        return -1;
+
+                *dst = (int32_t)((uint32_t)l << r);
+                break;
+
+        /* __func_rshift_sint() と同じく、負数は絶対値をシフトしてから符号を戻す */
+        case EC_OPE_RSHIFT:
+                if (r < 0 || l == INT32_MIN)
+                        return -1;
+
+                if (r >= 32)
+                        *dst = 0;
+                else if (l < 0)
+                        *dst = -((-l) >> r);
+                else
+                        *dst = l >> r;
+                break;
+
+        default:
+                return -1;
+        }
+
+        return 0;
+}
+
+/* double 同士の二項演算を dst へ計算する。畳み込めない場合は -1 を返す
+ * 比較演算の結果は sint の 1 または 0 となるので、その場合は is_int に 1 をセットする。
+ */
+static int32_t fold_binary_double(int32_t* dst, int32_t* is_int,
+                                  const uint32_t ope, const int32_t l, int32_t r)
+{
+        *is_int = 0;
+
+        switch (ope) {
+        case EC_OPE_ADD:        *dst = fold_add32(l, r); return 0;
+        case EC_OPE_SUB:        *dst = fold_sub32(l, r); return 0;
+
+        case EC_OPE_EQ:         *dst = (l == r); *is_int = 1; return 0;
+        case EC_OPE_NE:         *dst = (l != r); *is_int = 1; return 0;
+        case EC_OPE_LT:         *dst = (l < r); *is_int = 1; return 0;
+        case EC_OPE_GT:         *dst = (l > r); *is_int = 1; return 0;
+        case EC_OPE_LE:         *dst = (l <= r); *is_int = 1; return 0;
+        case EC_OPE_GE:         *dst = (l >= r); *is_int = 1; return 0;
+
+        case EC_OPE_MUL:
+        case EC_OPE_DIV:
+        case EC_OPE_MOD:
+                break;
+
+        /* ビット演算、シフトは実行時のエラーとして報告させる */
+        default:
+                return -1;
+        }
+
+        /* 以下は絶対値を取るので、INT32_MIN が現れる場合は畳み込まない */
+        if (l == INT32_MIN || r == INT32_MIN)
+                return -1;
+
+        if (ope == EC_OPE_MUL) {
+                *dst = fold_mul_double_module(l, r);
+                return 0;
+        }
+
+        /* __func_div_double() と同じく、R の逆数を乗算する */
+        if (ope == EC_OPE_DIV) {
+                if (r == 0)
+                        r = 1;
+
+                r = (int32_t)((uint32_t)(0x40000000 / r) << 2);
+                if (r == INT32_MIN)
+                        return -1;
+
+                *dst = fold_mul_double_module(l, r);
+                return 0;
+        }
+
+        /* __func_mod_double() と同じ手順の符号付き剰余 */
+        const int32_t lx = (l >= 0) ? l : -l;
+        const int32_t rx = (r >= 0) ? r : -r;
+
+        int32_t s = 0;
+        if (l > 0 && r < 0)
+                s = 1;
+        if (l < 0 && r > 0)
+                s = 2;
+
+        int32_t a = 0;
+        if (lx < rx && (s == 1 || s == 2)) {
+                s = 3;
+                a = fold_add32(l, r);
+        }
+
+        if (s != 3) {
+                if (r == 0)
+                        r = 1;
+
+                int32_t t = l / r;
+                if (t < 0)
+                        t -= 1;
+
+                a = fold_sub32(l, fold_mul32(t, r));
+        }
+
+        *dst = a;
+        return 0;
+}
+
+/* 定数 EC の値を整数型、固定小数型の何れとして扱うかを返す
+ * 整数型であれば 0 、固定小数型であれば 1 、畳み込みの対象としない型であれば -1 を返す。
+ */
+static int32_t fold_constant_kind(struct EC* ec)
+{
+        if (ec->type_expression != EC_CONSTANT || ec->var->indirect_len != 0)
+                return -1;
+
+        if (ec->var->type & (TYPE_FLOAT | TYPE_DOUBLE))
+                return 1;
+
+        if (ec->var->type & (TYPE_INT | TYPE_CHAR))
+                return 0;
+
+        return -1;
+}
+
+/* ec を、値 value 、型 type の定数 EC へ置き換える
+ * type は実行時に同じ演算を行った場合の結果の型とする。（TYPE_LITERAL はここで付ける）
+ * 定数は即値として扱われるので、iden は表示用の名前に過ぎない。
+ */
+static void fold_set_constant(struct EC* ec, const int32_t value, const uint32_t type)
+{
+        char iden[IDENLIST_STR_LEN];
+
+        ec->var = new_var();
+        if (type & (TYPE_FLOAT | TYPE_DOUBLE))
+                sprintf(iden, "@literalfix%d", value);
+        else
+                sprintf(iden, "@literal%d", value);
+
+        ec->var->type = type | TYPE_LITERAL;
+        ec->var->iden = iden_intern(iden);
+        ec->var->dim_len = 0;
+        ec->var->indirect_len = 0;
+
+        ec->var->const_variable = arena_alloc(sizeof(int));
+        *((int*)(ec->var->const_variable)) = value;
+
+        ec->type_expression = EC_CONSTANT;
+        ec->type_operator = 0;
+        ec->child_len = 0;
+
+        report_count.ec_fold++;
+}
+
+/* 子が共に定数の EC_CALC を畳み込む
+ * 型の扱いは var_binary_operation_new() と同じく、どちらかが固定小数であれば、もう一方の整数を << 16 して固定小数同士で演算する。
+ * 結果の型も同じく new_var_binary_type_promotion() で決める。（固定小数の比較演算の結果は int となる）
+ */
+static void fold_ec_calc(struct EC* ec)
+{
+        const int32_t lkind = fold_constant_kind(ec->child_ptr[0]);
+        const int32_t rkind = fold_constant_kind(ec->child_ptr[1]);
+        if (lkind == -1 || rkind == -1)
+                return;
+
+        int32_t l = *((int*)(ec->child_ptr[0]->var->const_variable));
+        int32_t r = *((int*)(ec->child_ptr[1]->var->const_variable));
+
+        const uint32_t type = new_var_binary_type_promotion(ec->child_ptr[0]->var,
+                                                            ec->child_ptr[1]->var)->type;
+
+        int32_t value;
+        if (lkind == 0 && rkind == 0) {
+                if (fold_binary_sint(&value, ec->type_operator, l, r) == -1)
+                        return;
+
+                fold_set_constant(ec, value, type);
+        } else {
+                if (lkind == 0)
+                        l = (int32_t)((uint32_t)l << 16);
+                if (rkind == 0)
+                        r = (int32_t)((uint32_t)r << 16);
+
+                int32_t is_int;
+                if (fold_binary_double(&value, &is_int, ec->type_operator, l, r) == -1)
+                        return;
+
+                fold_set_constant(ec, value, (is_int) ? (TYPE_SIGNED | TYPE_INT) : type);
+        }
+}
+
+/* 子が定数の EC_UNARY (-, ~, !) を畳み込む
+ * 結果の型は var_unary_operation_new() と同じくオペランドの型のままとする。（固定小数の ! の結果のみ int となる）
+ */
+static void fold_ec_unary(struct EC* ec)
+{
+        const int32_t kind = fold_constant_kind(ec->child_ptr[0]);
+        if (kind == -1)
+                return;
+
+        const int32_t l = *((int*)(ec->child_ptr[0]->var->const_variable));
+        const uint32_t type = ec->child_ptr[0]->var->type & ~TYPE_LITERAL;
+
+        switch (ec->type_operator) {
+        case EC_OPE_SUB:
+                fold_set_constant(ec, fold_neg32(l), type);
+                break;
+
+        case EC_OPE_NOT:
+                fold_set_constant(ec, (l == 0), (kind == 0) ? type : (TYPE_SIGNED | TYPE_INT));
+                break;
+
+        case EC_OPE_INV:
+                if (kind == 0)
+                        fold_set_constant(ec, ~l, type);
+                break;
+
+        default:
+                break;
+        }
+}
+
+/* ec をルートとする EC 木を、葉の側から定数畳み込みする
+ */
+void fold_ec(struct EC* ec)
+{
+        if (ec == NULL)
+                return;
+
+        if (ec->type_expression == EC_STATEMENT_LIST ||
+            ec->type_expression == EC_DECLARATION_LIST) {
+                if (ec->child_len == 0)
+                        return;
+
+                struct EC* item;
+                for (item = ec->child_ptr[0]; item != NULL; item = item->next)
+                        fold_ec(item);
+
+                return;
+        }
+
+        int32_t i;
+        for (i = 0; i < ec->child_len; i++)
+                fold_ec(ec->child_ptr[i]);
+
+        if (ec->type_expression == EC_CALC && ec->child_len == 2)
+                fold_ec_calc(ec);
+        else if (ec->type_expression == EC_UNARY && ec->child_len == 1)
+                fold_ec_unary(ec);
+}
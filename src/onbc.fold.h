@@ -0,0 +1,11 @@
+#include "onbc.ec.h"
+
+#ifndef __ONBC_FOLD_H__
+#define __ONBC_FOLD_H__
+
+/* 定数畳み込み関連
+ */
+
+void fold_ec(struct EC* ec);
+
+#endif /* __ONBC_FOLD_H__ */
@@ -22,7 +22,16 @@
 #include "onbc.print.h"
 #include "onbc.label.h"
 #include "onbc.var.h"
+#include "onbc.stack.h"
 #include "onbc.stackframe.h"
+#include "onbc.func.h"
+
+/* 現在の翻訳単位の世代番号
+ * new_context() の度にインクリメントされる。（スレッド毎に独立）
+ * beginF() のキャッシュなど、翻訳単位ごとに作り直す必要があるものは、この値と比較して有効性を判断する。
+ * （0 は「まだ一度も翻訳単位が作られていない」を意味する）
+ */
+__thread uint32_t cur_context_generation = 0;
 
 /* プリセット関数やアキュムレーターを呼び出し命令に対して、追加でさらに共通の定型命令を出力する。
  * すなわち、関数呼び出しのラッパ。
@@ -59,6 +68,8 @@ void retF(void)
  */
 void __define_user_function_return(void)
 {
+        stack_cache_flush();
+
         /* 関数呼び出し以前のスタックフレームまで戻す */
         pop_stackframe();
 
@@ -73,7 +84,9 @@ void __define_user_function_return(void)
         pA_mes("\\n");
 #endif /* DEBUG_SCOPE */
 
+        /* 戻り値は呼び出し元がメモリー上のスタックから受け取るので、レジスター上には残さない */
         push_stack("fixA");
+        stack_cache_flush();
 
         /* 関数呼び出し元の位置まで戻る */
         pop_labelstack();
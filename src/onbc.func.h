@@ -1,10 +1,13 @@
 #include <stdint.h>
 #include "onbc.print.h"
 #include "onbc.label.h"
+#include "onbc.stack.h"
 
 #ifndef __ONBC_FUNC_H__
 #define __ONBC_FUNC_H__
 
+extern __thread uint32_t cur_context_generation;
+
 void callF(const int32_t label);
 void retF(void);
 void __define_user_function_return(void);
@@ -19,13 +22,19 @@ void __define_user_function_return(void);
  * （つまり、関数辺り、2個のユニークラベルが消費される）
  * もちろん、cur_label_index_head は、副作用の無さそうなタイミングで +2 される。
  *
+ * サブルーチンの中身は呼び出し元ごとにスタックのレジスター状態が異なっても動くように、stack_cache_lock() してから出力する。
+ *
+ * ラベル番号は翻訳単位ごとに振り直されるので、unique_func_label は cur_context_generation が
+ * 登録時と同じ場合のみ有効。世代が変わっていれば、新たな翻訳単位の中で改めてサブルーチンを出力する。
+ * これらのキャッシュは、cur_context_generation と同様にスレッド毎に保持される。
+ *
  * 何故こんなハック的な解決方法を採ってるかというと、ただ単に大げさな方法による全面改修をするのが面倒くさかったから。
  */
 #define beginF()                                                        \
-        static int32_t unique_func_label;                               \
+        static __thread int32_t unique_func_label;                      \
                                                                         \
-        static int func_label_init_flag = 0;                            \
-        if (func_label_init_flag == 1) {                                \
+        static __thread uint32_t func_label_generation = 0;             \
+        if (func_label_generation == cur_context_generation) {          \
                 callF(unique_func_label);                               \
                 return;                                                 \
         }                                                               \
@@ -37,11 +46,13 @@ void __define_user_function_return(void);
         callF(unique_func_label);                                       \
         pA("PLIMM(P3F, %d);", end_label);                               \
                                                                         \
-        pA("LB(0, %d);", unique_func_label);
+        pA("LB(0, %d);", unique_func_label);                            \
+        stack_cache_lock();
 
 #define endF()                                                          \
+        stack_cache_unlock();                                           \
         retF();                                                         \
         pA("LB(0, %d);", end_label);                                    \
-        func_label_init_flag = 1;
+        func_label_generation = cur_context_generation;
 
 #endif /* __ONBC_FUNC_H__ */
@@ -0,0 +1,248 @@
+/* onbc.hash.c
+ * Copyright (C) 2013 Takeutch Kemeco
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "onbc.print.h"
+#include "onbc.hash.h"
+
+/* 文字列をキーとするハッシュテーブル
+ * 衝突はチェインで解決し、エントリー数がバケット数を越えた時点でバケット数を倍にして再配置する。
+ *
+ * new_iden_hash_table() で作成したテーブルは、キーに iden_intern() された文字列のみを用いる。
+ * 同じ名前は常に同じアドレスなので、キーの文字列は読まずにアドレスのみで比較する。
+ */
+
+/* FNV-1a 32bit ハッシュ */
+uint32_t hash_string(const char* key)
+{
+        uint32_t hash = 0x811c9dc5;
+        while (*key != '\0') {
+                hash ^= (unsigned char)*key++;
+                hash *= 0x01000193;
+        }
+
+        return hash;
+}
+
+/* テーブルの種類に応じた key のハッシュ値 */
+static uint32_t hash_table_hash(struct HashTable* table, const char* key)
+{
+        if (table->is_iden_key)
+                return (uint32_t)(((uintptr_t)key >> 3) * 0x9e3779b1);
+
+        return hash_string(key);
+}
+
+/* テーブルの種類に応じて、2つのキーが等しければ 1 を返す */
+static int32_t hash_table_key_eq(struct HashTable* table, const char* a, const char* b)
+{
+        if (table->is_iden_key)
+                return a == b;
+
+        return strcmp(a, b) == 0;
+}
+
+static struct HashEntry** hash_table_new_bucket(const uint32_t bucket_len)
+{
+        struct HashEntry** bucket = calloc(bucket_len, sizeof(*bucket));
+        if (bucket == NULL)
+                yyerror("system err: hash_table_new_bucket(), calloc()");
+
+        return bucket;
+}
+
+/* 空のハッシュテーブルを生成する。
+ * bucket_len は 2 の累乗であること。
+ * free_value はエントリーの値を開放する関数。（値を開放しない場合は NULL）
+ */
+struct HashTable* new_hash_table(const uint32_t bucket_len, void (*free_value)(void*))
+{
+        struct HashTable* table = malloc(sizeof(*table));
+        if (table == NULL)
+                yyerror("system err: new_hash_table(), malloc()");
+
+        table->bucket = hash_table_new_bucket(bucket_len);
+        table->bucket_len = bucket_len;
+        table->entry_len = 0;
+        table->free_value = free_value;
+        table->is_iden_key = 0;
+
+        return table;
+}
+
+/* iden_intern() された文字列をキーとする、空のハッシュテーブルを生成する。
+ * 引数は new_hash_table() と同様。
+ */
+struct HashTable* new_iden_hash_table(const uint32_t bucket_len, void (*free_value)(void*))
+{
+        struct HashTable* table = new_hash_table(bucket_len, free_value);
+        table->is_iden_key = 1;
+
+        return table;
+}
+
+static void hash_table_free_entry(struct HashTable* table, struct HashEntry* entry)
+{
+        if (table->free_value != NULL)
+                table->free_value(entry->value);
+
+        if (!table->is_iden_key)
+                free(entry->key);
+
+        free(entry);
+}
+
+/* ハッシュテーブルの全てのエントリーを削除する（バケットは確保したまま）
+ */
+void hash_table_clear(struct HashTable* table)
+{
+        uint32_t i;
+        for (i = 0; i < table->bucket_len; i++) {
+                struct HashEntry* entry = table->bucket[i];
+                while (entry != NULL) {
+                        struct HashEntry* next = entry->next;
+                        hash_table_free_entry(table, entry);
+                        entry = next;
+                }
+
+                table->bucket[i] = NULL;
+        }
+
+        table->entry_len = 0;
+}
+
+/* ハッシュテーブルを、全てのエントリーも含めて開放する
+ */
+void delete_hash_table(struct HashTable* table)
+{
+        hash_table_clear(table);
+        free(table->bucket);
+        free(table);
+}
+
+/* key に対応するエントリーのアドレスを返す。無ければ NULL を返す。
+ */
+static struct HashEntry* hash_table_search_entry(struct HashTable* table, const char* key)
+{
+        struct HashEntry* entry = table->bucket[hash_table_hash(table, key) & (table->bucket_len - 1)];
+        while (entry != NULL) {
+                if (hash_table_key_eq(table, entry->key, key))
+                        return entry;
+
+                entry = entry->next;
+        }
+
+        return NULL;
+}
+
+/* key に対応する値を返す。無ければ NULL を返す。
+ */
+void* hash_table_search(struct HashTable* table, const char* key)
+{
+        struct HashEntry* entry = hash_table_search_entry(table, key);
+        if (entry == NULL)
+                return NULL;
+
+        return entry->value;
+}
+
+/* バケット数を倍にして、全エントリーを再配置する
+ */
+static void hash_table_grow(struct HashTable* table)
+{
+        const uint32_t bucket_len = table->bucket_len * 2;
+        struct HashEntry** bucket = hash_table_new_bucket(bucket_len);
+
+        uint32_t i;
+        for (i = 0; i < table->bucket_len; i++) {
+                struct HashEntry* entry = table->bucket[i];
+                while (entry != NULL) {
+                        struct HashEntry* next = entry->next;
+                        const uint32_t j = hash_table_hash(table, entry->key) & (bucket_len - 1);
+                        entry->next = bucket[j];
+                        bucket[j] = entry;
+                        entry = next;
+                }
+        }
+
+        free(table->bucket);
+        table->bucket = bucket;
+        table->bucket_len = bucket_len;
+}
+
+/* key に value を結びつける。
+ * 既に同じ key が有った場合は、古い値を開放して value に置き換える。
+ */
+void hash_table_insert(struct HashTable* table, const char* key, void* value)
+{
+        struct HashEntry* entry = hash_table_search_entry(table, key);
+        if (entry != NULL) {
+                if (table->free_value != NULL)
+                        table->free_value(entry->value);
+
+                entry->value = value;
+                return;
+        }
+
+        if (table->entry_len >= table->bucket_len)
+                hash_table_grow(table);
+
+        entry = malloc(sizeof(*entry));
+        if (entry == NULL)
+                yyerror("system err: hash_table_insert(), malloc()");
+
+        if (table->is_iden_key) {
+                entry->key = (char*)key;
+        } else {
+                entry->key = malloc(strlen(key) + 1);
+                if (entry->key == NULL)
+                        yyerror("system err: hash_table_insert(), malloc()");
+
+                strcpy(entry->key, key);
+        }
+
+        entry->value = value;
+
+        const uint32_t i = hash_table_hash(table, key) & (table->bucket_len - 1);
+        entry->next = table->bucket[i];
+        table->bucket[i] = entry;
+        table->entry_len++;
+}
+
+/* key のエントリーを削除する。（値も開放される）
+ * 削除した場合は 1 、key が存在しなかった場合は 0 を返す。
+ */
+int32_t hash_table_remove(struct HashTable* table, const char* key)
+{
+        struct HashEntry** p = table->bucket + (hash_table_hash(table, key) & (table->bucket_len - 1));
+        while (*p != NULL) {
+                struct HashEntry* entry = *p;
+                if (hash_table_key_eq(table, entry->key, key)) {
+                        *p = entry->next;
+                        hash_table_free_entry(table, entry);
+                        table->entry_len--;
+                        return 1;
+                }
+
+                p = &(entry->next);
+        }
+
+        return 0;
+}
@@ -0,0 +1,38 @@
+#include <stdint.h>
+
+#ifndef __ONBC_HASH_H__
+#define __ONBC_HASH_H__
+
+/* 文字列をキーとするハッシュテーブル関連
+ */
+
+struct HashEntry {
+        char* key;
+        void* value;
+        struct HashEntry* next;
+};
+
+/* bucket[]: チェインの先頭へのポインターのリスト（要素数 bucket_len は 2 の累乗）
+ * entry_len: 登録されているエントリー数
+ * free_value: エントリーの値を開放する関数（NULL の場合は開放しない）
+ * is_iden_key: キーが iden_intern() された文字列の場合は 1 。
+ *              この場合、キーは複製せずにそのアドレスで比較する。
+ */
+struct HashTable {
+        struct HashEntry** bucket;
+        uint32_t bucket_len;
+        uint32_t entry_len;
+        void (*free_value)(void*);
+        int32_t is_iden_key;
+};
+
+uint32_t hash_string(const char* key);
+struct HashTable* new_hash_table(const uint32_t bucket_len, void (*free_value)(void*));
+struct HashTable* new_iden_hash_table(const uint32_t bucket_len, void (*free_value)(void*));
+void hash_table_clear(struct HashTable* table);
+void delete_hash_table(struct HashTable* table);
+void* hash_table_search(struct HashTable* table, const char* key);
+void hash_table_insert(struct HashTable* table, const char* key, void* value);
+int32_t hash_table_remove(struct HashTable* table, const char* key);
+
+#endif /* __ONBC_HASH_H__ */
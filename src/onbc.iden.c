@@ -19,40 +19,80 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include "onbc.print.h"
+#include "onbc.hash.h"
 #include "onbc.iden.h"
 
-/* IDENTIFIER 文字列用のスタック */
-#define IDENLIST_LEN 0x1000
-static char* idenlist[IDENLIST_LEN] = {[0 ... IDENLIST_LEN - 1] = NULL};
-static int32_t idenlist_head = 0;
+/* IDENTIFIER 文字列用のスタック（iden_intern() された文字列へのポインターを積む）
+ * 足りなくなれば倍に拡張する。
+ */
+static __thread const char** idenlist = NULL;
+static __thread int32_t idenlist_head = 0;
+static __thread int32_t idenlist_max = 0;
 
-/* idenlist に IDENTIFIER 文字列をプッシュする
- *
- * idenlist[idenlist_head]が0の場合はmallocされる。その領域が以後も使いまわされる。
- * （開放はしない。確保したまま）
+/* 識別子文字列を intern したもののテーブル
+ * 同じ内容の識別子は、翻訳単位中で常に同じアドレスの文字列となる。
+ */
+#define IDEN_INTERN_BUCKET_LEN 0x400
+static __thread struct HashTable* iden_intern_table = NULL;
+
+/* idenlist を空の状態に戻し、intern した識別子を全て開放する
+ */
+void init_idenlist(void)
+{
+        idenlist_head = 0;
+
+        if (iden_intern_table == NULL)
+                iden_intern_table = new_hash_table(IDEN_INTERN_BUCKET_LEN, free);
+        else
+                hash_table_clear(iden_intern_table);
+}
+
+/* src と同じ内容の、intern された識別子文字列を返す
+ * 返した文字列は翻訳単位の終了（次の init_idenlist()）まで有効で、書き換えてはならない。
  */
-void idenlist_push(const char* src)
+const char* iden_intern(const char* src)
 {
-        if (idenlist_head >= IDENLIST_LEN)
-                yyerror("system err: idenlist_push()");
+        if (iden_intern_table == NULL)
+                iden_intern_table = new_hash_table(IDEN_INTERN_BUCKET_LEN, free);
 
-        if(idenlist[idenlist_head] == NULL)
-                idenlist[idenlist_head] = malloc(IDENLIST_STR_LEN);
+        char* iden = hash_table_search(iden_intern_table, src);
+        if (iden != NULL)
+                return iden;
 
-        strcpy(idenlist[idenlist_head], src);
+        iden = malloc(strlen(src) + 1);
+        if (iden == NULL)
+                yyerror("system err: iden_intern(), malloc()");
+
+        strcpy(iden, src);
+        hash_table_insert(iden_intern_table, src, iden);
+
+        return iden;
+}
+
+/* idenlist に iden_intern() された IDENTIFIER 文字列をプッシュする
+ */
+void idenlist_push(const char* iden)
+{
+        if (idenlist_head >= idenlist_max) {
+                idenlist_max = (idenlist_max > 0) ? idenlist_max * 2 : 0x100;
+                idenlist = realloc(idenlist, sizeof(*idenlist) * idenlist_max);
+                if (idenlist == NULL)
+                        yyerror("system err: idenlist_push(), realloc()");
+        }
+
+        idenlist[idenlist_head] = iden;
         idenlist_head++;
 }
 
-/* idenlist から文字列をdstへポップする
- *
- * コピー渡しなので、十分な長さが確保されたdstを渡すこと
+/* idenlist から IDENTIFIER 文字列をポップする
  */
-void idenlist_pop(char* dst)
+const char* idenlist_pop(void)
 {
         idenlist_head--;
 
         if (idenlist_head < 0)
                 yyerror("system err: idenlist_pop()");
 
-        strcpy(dst, idenlist[idenlist_head]);
+        return idenlist[idenlist_head];
 }
@@ -3,7 +3,9 @@
 
 #define IDENLIST_STR_LEN 0x100
 
-void idenlist_push(const char* src);
-void idenlist_pop(char* dst);
+void init_idenlist(void);
+const char* iden_intern(const char* src);
+void idenlist_push(const char* iden);
+const char* idenlist_pop(void);
 
 #endif /* __ONBC_IDEN_H__ */
@@ -16,73 +16,147 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  */
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include "onbc.print.h"
+#include "onbc.hash.h"
 #include "onbc.label.h"
 
 /* 現在の使用可能なラベルインデックスのヘッド
- * この値から LABEL_INDEX_LEN 未満までの間が、まだ未使用なユニークラベルのサフィックス番号。
+ * この値以降が、まだ未使用なユニークラベルのサフィックス番号。
  * ユニークラベルをどこかに設定する度に、この値をインクリメントすること。
+ *
+ * ラベル数に上限は無く、翻訳単位の終了時点でのこの値が LOCALLABELS() として出力される。
  */
-int32_t cur_label_index_head = 0;
+__thread int32_t cur_label_index_head = 0;
 
-#define LABEL_STR_LEN 0x100
 struct Label {
-        char str[LABEL_STR_LEN];
+        const char* str;                /* iden_intern() されたラベル名 */
         int32_t val;
+        int32_t is_defined;             /* ラベル定義が既に現れていれば 1 */
+        int32_t refer_linenumber;       /* 定義より先に参照された場合の、最初の参照位置の行番号 */
 };
 
-static struct Label labellist[LABEL_INDEX_LEN];
+/* 名前付きラベルのリスト（登録順）と、名前からラベルを引くためのハッシュテーブル
+ * ラベル名は iden_intern() されたものなので、キーはアドレスで比較する。
+ */
+#define LABELLIST_TABLE_BUCKET_LEN 0x100
+static __thread struct Label** labellist = NULL;
+static __thread int32_t labellist_len = 0;
+static __thread int32_t labellist_max = 0;
+static __thread struct HashTable* labellist_table = NULL;
+
+extern __thread int32_t linenumber;
+
+/* ラベルリストを空の状態に戻し、ユニークラベルの番号も 0 から振り直す
+ * 翻訳単位ごとのコンパイル開始時に呼び出すこと。
+ */
+void init_labellist(void)
+{
+        int32_t i;
+        for (i = 0; i < labellist_len; i++)
+                free(labellist[i]);
+
+        labellist_len = 0;
+
+        if (labellist_table == NULL)
+                labellist_table = new_iden_hash_table(LABELLIST_TABLE_BUCKET_LEN, NULL);
+        else
+                hash_table_clear(labellist_table);
+
+        cur_label_index_head = 0;
+}
+
+/* ラベルリストから同名のラベルを探して、そのアドレスを返す。
+ * 無ければ NULL を返す。
+ */
+static struct Label* labellist_search_label(const char* str)
+{
+        return hash_table_search(labellist_table, str);
+}
 
-/* ラベルリストに既に同名が登録されているかを確認し、そのラベル番号を得る。
- * 無ければ -1 を返す。
+/* ラベルリストに新たにラベルを登録し、名前と新たなラベル番号を結びつける。
+ * この時点では未定義（参照のみ）の状態として登録される。
  */
-int32_t labellist_search_unsafe(const char* str)
+static struct Label* labellist_new_label(const char* str)
 {
-        int i;
-        for (i = 0; i < LABEL_INDEX_LEN; i++) {
-                if (strcmp(str, labellist[i].str) == 0)
-                        return labellist[i].val;
+        if (labellist_len >= labellist_max) {
+                labellist_max = (labellist_max == 0) ? 0x100 : labellist_max * 2;
+                labellist = realloc(labellist, sizeof(*labellist) * labellist_max);
+                if (labellist == NULL)
+                        yyerror("system err: labellist_new_label(), realloc()");
         }
 
-        return -1;
+        struct Label* label = malloc(sizeof(*label));
+        if (label == NULL)
+                yyerror("system err: labellist_new_label(), malloc()");
+
+        label->str = str;
+        label->val = cur_label_index_head;
+        cur_label_index_head++;
+
+        label->is_defined = 0;
+        label->refer_linenumber = linenumber;
+
+        labellist[labellist_len++] = label;
+        hash_table_insert(labellist_table, str, label);
+
+        return label;
 }
 
-/* ラベルリストに既に同名が登録されているかを確認し、そのラベル番号を得る。
- * 無ければエラー出力して終了
+/* goto 等でラベルを参照し、そのラベル番号を得る。
+ *
+ * ラベルの定義は参照よりも後に現れてもよい。
+ * まだ登録されていないラベルであれば、その場で新たなラベル番号を割り当てて未定義の状態で登録しておき、
+ * 後に labellist_add() で定義された時点で定義済みとする。
+ * （ラベル番号は定義より先に決まるので、出力済みの命令を書き換える必要は無い）
+ *
+ * 最後まで定義されなかったラベルは labellist_check_undefined() でエラーとなる。
  */
 int32_t labellist_search(const char* str)
 {
-        const int32_t tmp = labellist_search_unsafe(str);
-        if (tmp == -1)
-                yyerror("syntax err: 存在しないラベルを指定しました");
+        struct Label* label = labellist_search_label(str);
+        if (label == NULL)
+                label = labellist_new_label(str);
 
-        return tmp;
+        return label->val;
 }
 
-/* ラベルリストに新たにラベルを追加し、名前とラベル番号を結びつける。
- * これは名前とラベル番号による連想配列。
- * 既に同名の変数が存在した場合はエラー終了する。
+/* ラベルを定義し、そのラベル番号を返す。
+ * 既に参照だけされていたラベルであれば、その時に割り当てたラベル番号を用いる。
+ * 既に同名のラベルが定義されていた場合はエラー終了する。
  */
-void labellist_add(const char* str)
+int32_t labellist_add(const char* str)
 {
-        if (labellist_search_unsafe(str) != -1)
+        struct Label* label = labellist_search_label(str);
+        if (label == NULL)
+                label = labellist_new_label(str);
+        else if (label->is_defined)
                 yyerror("syntax err: 既に同名のラベルが存在します");
 
-        if (cur_label_index_head >= LABEL_INDEX_LEN)
-                yyerror("system err: コンパイラーが設定可能なラベル数を越えました");
+        label->is_defined = 1;
+
+        return label->val;
+}
 
-        int i;
-        for (i = 0; i < LABEL_INDEX_LEN; i++) {
-                if (labellist[i].str[0] == '\0') {
-                        strcpy(labellist[i].str, str);
+/* 参照されたが定義されなかったラベルが有ればエラー終了する。
+ * 翻訳単位の終端で呼び出すこと。
+ */
+void labellist_check_undefined(void)
+{
+        int32_t i;
+        for (i = 0; i < labellist_len; i++) {
+                struct Label* label = labellist[i];
+                if (label->is_defined)
+                        continue;
 
-                        labellist[i].val = cur_label_index_head;
-                        cur_label_index_head++;
+                char tmp[0x1000];
+                snprintf(tmp, sizeof(tmp), "syntax err: 存在しないラベル %s を指定しました", label->str);
 
-                        return;
-                }
+                linenumber = label->refer_linenumber;
+                yyerror(tmp);
         }
 }
 
@@ -120,6 +194,6 @@ void pop_labelstack(void)
 void init_labelstack(void)
 {
         pB("VPtr labelstack_ptr:P02;");
-        pB("junkApi_malloc(labelstack_ptr, T_VPTR, %d);", LABEL_INDEX_LEN);
+        pB("junkApi_malloc(labelstack_ptr, T_VPTR, %d);", LABELSTACK_LEN);
         pB("VPtr labelstack_socket:%s;", CUR_RETURN_LABEL);
 };
@@ -3,17 +3,20 @@
 #ifndef __ONBC_LABEL_H__
 #define __ONBC_LABEL_H__
 
-/* ラベルの使用可能最大数 */
-#define LABEL_INDEX_LEN 2048
+/* ラベルスタック（gosub の戻り先ラベルの保存用）の深さ */
+#define LABELSTACK_LEN 2048
 
 /* gosub での return 先ラベルの保存用に使うポインターレジスター */
 #define CUR_RETURN_LABEL "P03"
 
-extern int32_t cur_label_index_head;
+extern __thread int32_t cur_label_index_head;
 
-int32_t labellist_search_unsafe(const char* str);
+/* 以下の str を受け取る関数には、iden_intern() された文字列を渡すこと。
+ */
+void init_labellist(void);
 int32_t labellist_search(const char* str);
-void labellist_add(const char* str);
+int32_t labellist_add(const char* str);
+void labellist_check_undefined(void);
 void push_labelstack(void);
 void pop_labelstack(void);
 void init_labelstack(void);
@@ -22,52 +22,39 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include "onbc.report.h"
+#include "onbc.file.h"
 
-extern char filepath[0x1000];
-extern int32_t linenumber;
+extern __thread const char* filepath;
+extern __thread int32_t linenumber;
 
 /* 現在の filepath のファイル中から、line行目を文字列として dst へ読み出す。
- * dst には十分な長さのバッファーを渡すこと。
+ * dst には 0x1000 バイト以上のバッファーを渡すこと。（それより長い行は切り詰める）
  *
  * line が 1 未満、または EOF 以降の場合は -1 を返す。
  *
+ * ファイルの内容と行の索引は source_file_load() のキャッシュから得るので、ファイルを開き直すことは無い。
+ *
  * これは主にエラー表示時に、補助的な情報として表示する文字列用。
  * メインの字句解析や構文解析に用いるような用途には使ってない。
  */
 int32_t read_line_file(char* dst, const int32_t line)
 {
-        if (line < 1)
+        struct SourceFile* file = source_file_load(filepath);
+        if (file == NULL)
                 return -1;
 
-        FILE* fp = fopen(filepath, "rt");
-
-        /* 目的行までシーク
-         */
-        int i = line - 1;
-        while (i-->0) {
-                while (1) {
-                        int c = fgetc(fp);
-                        if (c == '\n')
-                                break;
-
-                        if (c == EOF)
-                                return -1;
-                }
-        }
-
-        /* 改行、または EOF までを dst へ読み出す
-         */
-        while (1) {
-                int c = fgetc(fp);
-                if (c == '\n' || c == EOF)
-                        break;
+        size_t len;
+        const char* src = source_file_line(file, line, &len);
+        if (src == NULL)
+                return -1;
 
-                *dst++ = c;
-        }
+        if (len > 0x1000 - 1)
+                len = 0x1000 - 1;
 
-        *dst = '\0';
+        memcpy(dst, src, len);
+        dst[len] = '\0';
 
-        fclose(fp);
         return 0;
 }
 
@@ -96,10 +83,8 @@ void yyerror(const char *error_message)
         exit(EXIT_FAILURE);
 }
 
-extern FILE* yyin;
-extern FILE* yyout;
-extern FILE* yyaskA;
-extern FILE* yyaskB;
+extern __thread FILE* yyaskA;
+extern __thread FILE* yyaskB;
 
 /* 出力ファイル yyaskA へ文字列を書き出す関数 */
 void pA(const char* fmt, ...)
@@ -111,6 +96,8 @@ void pA(const char* fmt, ...)
         va_end(ap);
 
         fputs("\n", yyaskA);
+
+        report_count.pA_line++;
 }
 
 /* 出力ファイル yyaskB へ文字列を書き出す関数 */
@@ -123,6 +110,8 @@ void pB(const char* fmt, ...)
         va_end(ap);
 
         fputs("\n", yyaskB);
+
+        report_count.pB_line++;
 }
 
 /* 出力ファイル yyaskA へ文字列を書き出す関数（改行無し）
@@ -0,0 +1,417 @@
+/* onbc.program.c
+ * Copyright (C) 2013 Takeutch Kemeco
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "onbc.print.h"
+#include "onbc.var.h"
+#include "onbc.hash.h"
+#include "onbc.ec.h"
+#include "onbc.report.h"
+#include "onbc.arena.h"
+#include "onbc.fold.h"
+#include "onbc.program.h"
+
+/* プログラム全体の EC 木関連
+ *
+ * 通常は external_declaration が還元される毎に、その場で translate_ec() で翻訳して arena_reset() する。
+ * --whole-program が指定された場合は、翻訳単位の終端まで全ての external_declaration の EC 木を保持しておき、
+ * 解析パス (program_pass_table[]) を全て実行してから、まとめて翻訳する。
+ *
+ * 解析パスの結果は識別子ごとに struct ProgramSymbol として保持し、翻訳中は program_symbol_search() で引ける。
+ * （const_value は translate_ec_variable() で即値への置き換えに用いる）
+ * （EC 木を全て保持するので、メモリー使用量はプログラムの長さに比例する）
+ */
+
+/* --whole-program が指定された場合に 1 。
+ * スレッドを作る前に設定し、以後は読むだけ。
+ */
+int32_t program_enable = 0;
+
+/* 保持している external_declaration のリスト（EC_DECLARATION_LIST） */
+static __thread struct EC* program_root = NULL;
+
+/* 識別子から struct ProgramSymbol を引くためのハッシュテーブル
+ * 識別子は iden_intern() されたものなので、キーはアドレスで比較する。
+ */
+#define PROGRAM_SYMBOL_TABLE_BUCKET_LEN 0x400
+static __thread struct HashTable* program_symbol_table = NULL;
+
+static void delete_program_symbol(void* p)
+{
+        struct ProgramSymbol* sym = p;
+        free(sym->callee);
+        free(sym);
+}
+
+/* 翻訳単位ごとに、保持している EC 木と解析結果を初期化する
+ */
+void init_program(void)
+{
+        program_root = NULL;
+
+        if (program_symbol_table == NULL)
+                program_symbol_table = new_iden_hash_table(PROGRAM_SYMBOL_TABLE_BUCKET_LEN,
+                                                           delete_program_symbol);
+        else
+                hash_table_clear(program_symbol_table);
+}
+
+/* 現在のスレッド用の解析結果を開放する
+ */
+void free_program(void)
+{
+        if (program_symbol_table != NULL) {
+                delete_hash_table(program_symbol_table);
+                program_symbol_table = NULL;
+        }
+
+        program_root = NULL;
+}
+
+/* iden の解析結果を返す。解析されていない識別子の場合は NULL を返す
+ */
+struct ProgramSymbol* program_symbol_search(const char* iden)
+{
+        if (program_symbol_table == NULL)
+                return NULL;
+
+        return hash_table_search(program_symbol_table, iden);
+}
+
+/* iden の解析結果を返す。無ければ新たに追加する
+ */
+static struct ProgramSymbol* program_symbol_get(const char* iden)
+{
+        struct ProgramSymbol* sym = hash_table_search(program_symbol_table, iden);
+        if (sym != NULL)
+                return sym;
+
+        sym = malloc(sizeof(*sym));
+        if (sym == NULL)
+                yyerror("system err: program_symbol_get(), malloc()");
+
+        memset(sym, 0, sizeof(*sym));
+        sym->iden = iden;
+
+        hash_table_insert(program_symbol_table, iden, sym);
+
+        return sym;
+}
+
+/* caller から callee への呼び出しを call graph に加える（同じ呼び出し先は1度だけ登録する）
+ */
+static void program_symbol_add_callee(struct ProgramSymbol* caller, struct ProgramSymbol* callee)
+{
+        int32_t i;
+        for (i = 0; i < caller->callee_len; i++) {
+                if (caller->callee[i] == callee)
+                        return;
+        }
+
+        if (caller->callee_len >= caller->callee_max) {
+                caller->callee_max = (caller->callee_max > 0) ? caller->callee_max * 2 : 4;
+                caller->callee = realloc(caller->callee, sizeof(*(caller->callee)) * caller->callee_max);
+                if (caller->callee == NULL)
+                        yyerror("system err: program_symbol_add_callee(), realloc()");
+        }
+
+        caller->callee[caller->callee_len] = callee;
+        caller->callee_len++;
+}
+
+/* EC 木の走査関連
+ */
+
+typedef void (*program_visit_func)(struct EC* ec, void* arg);
+
+/* ec をルートとする EC 木の全てのノードを、親から先に visit へ渡す
+ * EC_STATEMENT_LIST, EC_DECLARATION_LIST は child_ptr[1] が末尾の要素を指すだけなので、要素を next で辿る。
+ */
+static void program_walk(struct EC* ec, program_visit_func visit, void* arg)
+{
+        if (ec == NULL)
+                return;
+
+        visit(ec, arg);
+
+        if (ec->type_expression == EC_STATEMENT_LIST ||
+            ec->type_expression == EC_DECLARATION_LIST) {
+                if (ec->child_len == 0)
+                        return;
+
+                struct EC* item;
+                for (item = ec->child_ptr[0]; item != NULL; item = item->next)
+                        program_walk(item, visit, arg);
+
+                return;
+        }
+
+        int32_t i;
+        for (i = 0; i < ec->child_len; i++)
+                program_walk(ec->child_ptr[i], visit, arg);
+}
+
+/* 保持している external_declaration ごとに、その EC 木を visit で走査する
+ * arg には、関数定義であればその関数の struct ProgramSymbol 、トップレベルの命令であれば NULL を渡す。
+ */
+static void program_walk_all(program_visit_func visit)
+{
+        struct EC* item;
+        for (item = program_root->child_ptr[0]; item != NULL; item = item->next) {
+                struct ProgramSymbol* func = NULL;
+                if (item->type_expression == EC_FUNCTION_DEFINITION)
+                        func = program_symbol_get(item->child_ptr[0]->var->iden);
+
+                program_walk(item, visit, func);
+        }
+}
+
+/* 解析パス: call graph
+ * 関数定義と関数呼び出しを集めて callee[] を作り、トップレベルの命令から到達できる関数に is_reachable をセットする。
+ */
+static void program_visit_call(struct EC* ec, void* arg)
+{
+        struct ProgramSymbol* caller = arg;
+
+        if (ec->type_expression == EC_FUNCTION_DEFINITION) {
+                caller->is_function = 1;
+                return;
+        }
+
+        if (ec->type_expression != EC_POSTFIX || ec->type_operator != EC_OPE_FUNCTION)
+                return;
+
+        struct ProgramSymbol* callee = program_symbol_get(ec->var->iden);
+        callee->call_count++;
+
+        if (caller != NULL)
+                program_symbol_add_callee(caller, callee);
+        else
+                callee->is_reachable = 1;
+}
+
+static void program_pass_call_graph(void)
+{
+        program_walk_all(program_visit_call);
+
+        /* トップレベルから直接呼ばれる関数を起点に、callee[] を辿って到達可能な関数へ印を付ける。
+         * 再帰が深くならないように、未処理の関数は明示的なスタックに積む。
+         */
+        struct ProgramSymbol** stack = NULL;
+        int32_t stack_len = 0;
+        int32_t stack_max = 0;
+
+        uint32_t b;
+        for (b = 0; b < program_symbol_table->bucket_len; b++) {
+                struct HashEntry* entry;
+                for (entry = program_symbol_table->bucket[b]; entry != NULL; entry = entry->next) {
+                        struct ProgramSymbol* sym = entry->value;
+                        if (!sym->is_reachable)
+                                continue;
+
+                        if (stack_len >= stack_max) {
+                                stack_max = (stack_max > 0) ? stack_max * 2 : 0x40;
+                                stack = realloc(stack, sizeof(*stack) * stack_max);
+                                if (stack == NULL)
+                                        yyerror("system err: program_pass_call_graph(), realloc()");
+                        }
+
+                        stack[stack_len++] = sym;
+                }
+        }
+
+        while (stack_len > 0) {
+                struct ProgramSymbol* sym = stack[--stack_len];
+
+                int32_t i;
+                for (i = 0; i < sym->callee_len; i++) {
+                        struct ProgramSymbol* callee = sym->callee[i];
+                        if (callee->is_reachable)
+                                continue;
+
+                        callee->is_reachable = 1;
+
+                        if (stack_len >= stack_max) {
+                                stack_max = (stack_max > 0) ? stack_max * 2 : 0x40;
+                                stack = realloc(stack, sizeof(*stack) * stack_max);
+                                if (stack == NULL)
+                                        yyerror("system err: program_pass_call_graph(), realloc()");
+                        }
+
+                        stack[stack_len++] = callee;
+                }
+        }
+
+        free(stack);
+}
+
+/* 解析パス: 使用回数
+ * 識別子ごとに、宣言、参照、書き換えの回数を数える。
+ */
+static void program_visit_write(struct EC* ec, void* arg)
+{
+        if (ec->type_expression == EC_PRIMARY && ec->type_operator == EC_OPE_VARIABLE)
+                program_symbol_get(ec->var->iden)->write_count++;
+}
+
+static void program_visit_use(struct EC* ec, void* arg)
+{
+        if (ec->type_expression == EC_DECLARATOR) {
+                program_symbol_get(ec->var->iden)->def_count++;
+        } else if (ec->type_expression == EC_PRIMARY && ec->type_operator == EC_OPE_VARIABLE) {
+                program_symbol_get(ec->var->iden)->use_count++;
+        } else if ((ec->type_expression == EC_ASSIGNMENT && ec->type_operator == EC_OPE_SUBST) ||
+                   (ec->type_expression == EC_UNARY && ec->type_operator == EC_OPE_ADDRESS) ||
+                   (ec->type_expression == EC_INLINE_ASSEMBLER_STATEMENT &&
+                    ec->type_operator == EC_OPE_ASM_SUBST_RTOV)) {
+                /* 書き換えられ得る側の式に含まれる変数は、全て書き換えられるものとみなす（添字の変数なども含めて安全側へ倒す） */
+                program_walk(ec->child_ptr[0], program_visit_write, NULL);
+        }
+}
+
+static void program_pass_use_count(void)
+{
+        program_walk_all(program_visit_use);
+}
+
+/* 解析パス: 定数グローバル変数
+ * トップレベルで定数により初期化され、プログラム中で書き換えられず、同名の宣言も他に無いスカラー変数に const_value をセットする。
+ * 翻訳時に即値へ置き換えても値と型が変わらないように、int 型の変数の整数の初期値と、float 型の変数の固定小数の初期値に限る。
+ * arg には宣言の型（EC_DECLARATION の型指定子）を渡す。
+ * program_pass_use_count() の後に実行すること。
+ */
+static void program_visit_const_global(struct EC* ec, void* arg)
+{
+        const uint32_t type = *((const uint32_t*)arg);
+
+        if (ec->type_expression != EC_INIT_DECLARATOR)
+                return;
+
+        struct EC* declarator = ec->child_ptr[0];
+        struct EC* initializer = ec->child_ptr[1];
+
+        if (declarator->type_expression != EC_DECLARATOR || initializer->type_expression != EC_CONSTANT)
+                return;
+
+        if ((declarator->var->type & (TYPE_ARRAY | TYPE_FUNCTION)) || declarator->var->indirect_len != 0)
+                return;
+
+        if (type & (TYPE_CHAR | TYPE_SHORT | TYPE_UNSIGNED | TYPE_STRUCT | TYPE_ENUM |
+                    TYPE_VOLATILE | TYPE_WIND | TYPE_REGISTER | TYPE_EXTERN | TYPE_TYPEDEF))
+                return;
+
+        if (type & (TYPE_FLOAT | TYPE_DOUBLE)) {
+                if (!(initializer->var->type & (TYPE_FLOAT | TYPE_DOUBLE)))
+                        return;
+        } else {
+                if (!(initializer->var->type & TYPE_INT))
+                        return;
+        }
+
+        struct ProgramSymbol* sym = program_symbol_get(declarator->var->iden);
+        if (sym->def_count == 1 && sym->write_count == 0 && !sym->is_function)
+                sym->const_value = initializer;
+}
+
+static void program_pass_const_global(void)
+{
+        struct EC* item;
+        for (item = program_root->child_ptr[0]; item != NULL; item = item->next) {
+                if (item->type_expression == EC_DECLARATION)
+                        program_walk(item->child_ptr[0], program_visit_const_global, &(item->var->type));
+        }
+}
+
+/* 解析パスの表
+ * 翻訳の前に、この順に実行する。最適化のパスもここへ加える。
+ */
+typedef void (*program_pass_func)(void);
+
+static const program_pass_func program_pass_table[] = {
+        program_pass_call_graph,
+        program_pass_use_count,
+        program_pass_const_global,
+};
+
+#define PROGRAM_PASS_LEN (sizeof(program_pass_table) / sizeof(program_pass_table[0]))
+
+/* 解析結果の集計を --time-report のカウンターへ加える
+ */
+static void program_report(void)
+{
+        uint32_t b;
+        for (b = 0; b < program_symbol_table->bucket_len; b++) {
+                struct HashEntry* entry;
+                for (entry = program_symbol_table->bucket[b]; entry != NULL; entry = entry->next) {
+                        struct ProgramSymbol* sym = entry->value;
+                        if (sym->is_function) {
+                                report_count.program_func++;
+                                if (!sym->is_reachable)
+                                        report_count.program_func_unreachable++;
+                        }
+
+                        if (sym->const_value != NULL)
+                                report_count.program_const_global++;
+                }
+        }
+}
+
+/* 還元された external_declaration を受け取る
+ * 定数畳み込みを行ってから、通常はその場で翻訳する。--whole-program の場合は program_end() まで保持する。
+ */
+void program_add(struct EC* ec)
+{
+        fold_ec(ec);
+
+        if (!program_enable) {
+                translate_ec(ec);
+                arena_reset();
+                return;
+        }
+
+        if (program_root == NULL) {
+                program_root = new_ec();
+                program_root->type_expression = EC_DECLARATION_LIST;
+        }
+
+        ec_list_append(program_root, ec);
+}
+
+/* 翻訳単位の終端で呼び出す
+ * --whole-program の場合は、保持している EC 木に解析パスを実行してから、まとめて翻訳する。
+ */
+void program_end(void)
+{
+        if (!program_enable || program_root == NULL)
+                return;
+
+        uint32_t i;
+        for (i = 0; i < PROGRAM_PASS_LEN; i++) {
+                program_pass_table[i]();
+                report_count.program_pass++;
+        }
+
+        program_report();
+
+        translate_ec(program_root);
+        arena_reset();
+        program_root = NULL;
+}
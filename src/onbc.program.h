@@ -0,0 +1,45 @@
+#include <stdint.h>
+#include "onbc.ec.h"
+
+#ifndef __ONBC_PROGRAM_H__
+#define __ONBC_PROGRAM_H__
+
+/* プログラム全体の EC 木（--whole-program）関連
+ */
+
+/* プログラム中の識別子ごとの解析結果
+ *
+ * iden: 識別子（iden_intern() されたもの）
+ * is_function: 関数定義であれば 1
+ * def_count: 宣言された回数（関数の引数、ローカル変数も含む）
+ * use_count: 変数として参照された回数
+ * write_count: 代入の左辺、& によるアドレス取得、asm() による書き込みの対象となった回数
+ * call_count: 関数として呼び出された回数
+ * is_reachable: トップレベルの命令から呼び出しを辿って到達できる関数であれば 1
+ * const_value: 定数で初期化され、以後書き換えられないグローバル変数であれば、その初期値の EC_CONSTANT 。そうでなければ NULL
+ * callee[]: この関数から呼び出す関数のリスト（call graph）
+ * callee_len: callee[] に登録されている関数の数
+ */
+struct ProgramSymbol {
+        const char* iden;
+        int32_t is_function;
+        int32_t def_count;
+        int32_t use_count;
+        int32_t write_count;
+        int32_t call_count;
+        int32_t is_reachable;
+        struct EC* const_value;
+        struct ProgramSymbol** callee;
+        int32_t callee_len;
+        int32_t callee_max;
+};
+
+extern int32_t program_enable;
+
+void init_program(void);
+void free_program(void);
+void program_add(struct EC* ec);
+void program_end(void);
+struct ProgramSymbol* program_symbol_search(const char* iden);
+
+#endif /* __ONBC_PROGRAM_H__ */
@@ -0,0 +1,151 @@
+/* onbc.report.c
+ * Copyright (C) 2013 Takeutch Kemeco
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "onbc.report.h"
+
+/* --time-report 関連
+ * 翻訳単位ごとに、各工程の経過時間、CPU時間、最大RSS、および各種カウンターを集計して表示する。
+ */
+
+/* --time-report が指定された場合に 1 。
+ * スレッドを作る前に設定し、以後は読むだけ。
+ */
+int32_t report_enable = 0;
+
+/* 現在の翻訳単位のカウンター */
+__thread struct ReportCount report_count;
+
+/* 工程ごとの計測結果
+ */
+struct ReportPhase {
+        double wall_begin;      /* 開始時の経過時間 [秒] */
+        double cpu_begin;       /* 開始時のスレッドのCPU時間 [秒] */
+        double wall;            /* 工程の経過時間 [秒] */
+        double cpu;             /* 工程のスレッドのCPU時間 [秒] */
+        long maxrss;            /* 工程終了時点でのプロセスの最大RSS [KiB] */
+};
+
+static __thread struct ReportPhase report_phase[REPORT_PHASE_LEN];
+
+static const char* report_phase_name[REPORT_PHASE_LEN] = {
+        [REPORT_PHASE_MAIN_PROCESS]     = "lex + parse + translate",
+        [REPORT_PHASE_MARGE]            = "marge",
+        [REPORT_PHASE_TUNE_PROCESS]     = "tune_process lex",
+};
+
+static double timespec_to_sec(const clockid_t clock_id)
+{
+        struct timespec ts;
+        clock_gettime(clock_id, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 翻訳単位の開始時に、カウンターと計測結果を初期化する
+ */
+void report_init(void)
+{
+        memset(&report_count, 0, sizeof(report_count));
+        memset(report_phase, 0, sizeof(report_phase));
+}
+
+/* 工程 phase の計測を開始する
+ */
+void report_begin(const int32_t phase)
+{
+        if (!report_enable)
+                return;
+
+        struct ReportPhase* p = report_phase + phase;
+        p->wall_begin = timespec_to_sec(CLOCK_MONOTONIC);
+        p->cpu_begin = timespec_to_sec(CLOCK_THREAD_CPUTIME_ID);
+}
+
+/* 工程 phase の計測を終了する
+ */
+void report_end(const int32_t phase)
+{
+        if (!report_enable)
+                return;
+
+        struct ReportPhase* p = report_phase + phase;
+        p->wall = timespec_to_sec(CLOCK_MONOTONIC) - p->wall_begin;
+        p->cpu = timespec_to_sec(CLOCK_THREAD_CPUTIME_ID) - p->cpu_begin;
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        p->maxrss = usage.ru_maxrss;
+}
+
+/* 翻訳単位 in_path の計測結果を stderr へ表示する
+ * 並列コンパイル時に他のスレッドの表示と混ざらないように、stderr をロックしてまとめて書き出す。
+ */
+void report_print(const char* in_path)
+{
+        if (!report_enable)
+                return;
+
+        flockfile(stderr);
+
+        fprintf(stderr, "time-report: %s\n", in_path);
+        fprintf(stderr, "  %-22s %12s %12s %14s\n", "phase", "wall[ms]", "cpu[ms]", "maxrss[KiB]");
+
+        double wall = 0;
+        double cpu = 0;
+        int32_t i;
+        for (i = 0; i < REPORT_PHASE_LEN; i++) {
+                struct ReportPhase* p = report_phase + i;
+                fprintf(stderr, "  %-22s %12.3f %12.3f %14ld\n",
+                        report_phase_name[i], p->wall * 1e3, p->cpu * 1e3, p->maxrss);
+
+                wall += p->wall;
+                cpu += p->cpu;
+        }
+
+        fprintf(stderr, "  %-22s %12.3f %12.3f\n", "total", wall * 1e3, cpu * 1e3);
+
+        fprintf(stderr, "  EC nodes allocated:    %llu\n", (unsigned long long)report_count.ec_new);
+        fprintf(stderr, "  struct Var allocated:  %llu\n", (unsigned long long)report_count.var_new);
+        fprintf(stderr, "  struct Var copies:     %llu\n", (unsigned long long)report_count.var_copy);
+        fprintf(stderr, "  EC constants folded:   %llu\n", (unsigned long long)report_count.ec_fold);
+        fprintf(stderr, "  pA lines:              %llu\n", (unsigned long long)report_count.pA_line);
+        fprintf(stderr, "  pB lines:              %llu\n", (unsigned long long)report_count.pB_line);
+        fprintf(stderr, "  stack pushes in regs:  %llu (spilled %llu)\n",
+                (unsigned long long)report_count.stack_cache_push,
+                (unsigned long long)report_count.stack_spill);
+
+        if (report_count.program_pass > 0) {
+                fprintf(stderr, "  whole-program passes:  %llu\n", (unsigned long long)report_count.program_pass);
+                fprintf(stderr, "  functions:             %llu (unreachable %llu)\n",
+                        (unsigned long long)report_count.program_func,
+                        (unsigned long long)report_count.program_func_unreachable);
+                fprintf(stderr, "  constant globals:      %llu (propagated %llu)\n",
+                        (unsigned long long)report_count.program_const_global,
+                        (unsigned long long)report_count.program_const_propagate);
+        }
+
+        fprintf(stderr, "\n");
+
+        funlockfile(stderr);
+}
@@ -0,0 +1,39 @@
+#include <stdint.h>
+
+#ifndef __ONBC_REPORT_H__
+#define __ONBC_REPORT_H__
+
+/* --time-report で計測する工程
+ */
+#define REPORT_PHASE_MAIN_PROCESS       0       /* 字句解析、構文解析と translate_ec() */
+#define REPORT_PHASE_MARGE              1       /* yyaskB, yyaskA のマージ */
+#define REPORT_PHASE_TUNE_PROCESS       2       /* tune_process による字句解析 */
+#define REPORT_PHASE_LEN                3
+
+/* --time-report で集計するカウンター
+ */
+struct ReportCount {
+        uint64_t ec_new;        /* new_ec() で確保した EC の数 */
+        uint64_t var_new;       /* new_var() で確保した Var の数 */
+        uint64_t var_copy;      /* var_copy() による Var のコピー回数 */
+        uint64_t ec_fold;       /* 定数畳み込みで EC_CONSTANT へ置き換えた EC の数 */
+        uint64_t pA_line;       /* pA() で書き出した行数 */
+        uint64_t pB_line;       /* pB() で書き出した行数 */
+        uint64_t stack_cache_push;      /* レジスター上へ行ったスタックのプッシュ回数 */
+        uint64_t stack_spill;   /* レジスターからメモリー上のスタックへ退避した回数 */
+        uint64_t program_pass;  /* --whole-program で実行した解析パスの数 */
+        uint64_t program_func;  /* --whole-program で解析した関数定義の数 */
+        uint64_t program_func_unreachable; /* そのうち、トップレベルから到達できない関数の数 */
+        uint64_t program_const_global;     /* --whole-program で見つけた定数グローバル変数の数 */
+        uint64_t program_const_propagate;  /* そのうち、参照を即値へ置き換えた回数 */
+};
+
+extern int32_t report_enable;
+extern __thread struct ReportCount report_count;
+
+void report_init(void);
+void report_begin(const int32_t phase);
+void report_end(const int32_t phase);
+void report_print(const char* in_path);
+
+#endif /* __ONBC_REPORT_H__ */
@@ -16,20 +16,133 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
  */
 
+#include <stdint.h>
 #include "onbc.print.h"
 #include "onbc.mem.h"
+#include "onbc.report.h"
 #include "onbc.stack.h"
 
 /* スタック構造関連
  * これはプッシュ・ポップだけの単純なスタック構造を提供する。
  * 実際には mem の STACK_BEGIN_ADDRESS 以降のメモリー領域を用いる。
+ *
+ * ただし、スタック上位の STACK_CACHE_LEN 個までの要素は、メモリーではなくレジスター stack_cache** に置く。
+ * （式の評価中の一時的な値は、ほとんどがプッシュした直後にポップされるので、メモリーへのアクセスを省ける）
+ * どの要素がどのレジスターに有るかはコンパイル時に確定しているので、実行時の管理は不要。
+ * レジスターが足りなくなった場合は、最も古い要素からメモリーへ退避 (spill) する。
+ *
+ * stack_head はメモリー上のスタックの先頭を指し、レジスター上の要素はその上に積まれているものとして扱う。
+ * 実行時にメモリー上のスタックが正確である必要が有る位置（関数呼び出し、ラベル、ジャンプ、stack_head の直接操作など）では、
+ * 必ず事前に stack_cache_flush() でレジスター上の要素をメモリーへ書き出すこと。
+ */
+
+/* レジスター上の要素を保持するためのレジスター
+ * R2C - R2F は register 変数に用いる。R30 以降は junkApi_*() が用いるので使わない。
+ * register 変数のレジスターはインラインアセンブラの前後で退避しないので、asm() 内で R2C - R2F を書き換えてはならない（予約済み）。
+ */
+static const char* const stack_cache_reg[STACK_CACHE_LEN] = {
+        "stack_cache00", "stack_cache01", "stack_cache02", "stack_cache03",
+        "stack_cache04", "stack_cache05", "stack_cache06", "stack_cache07",
+        "stack_cache08",
+};
+
+/* stack_cache_reg[] をリングバッファーとして用いる。
+ * stack_cache_bottom はレジスター上の最も古い要素の位置、stack_cache_len はレジスター上の要素数。
+ */
+static __thread int32_t stack_cache_bottom = 0;
+static __thread int32_t stack_cache_len = 0;
+
+/* 0 以外の場合は、レジスターを用いずにメモリー上のスタックを直接操作する
+ * （beginF() によるサブルーチンの中など、呼び出し元ごとにレジスターの状態が異なる場合）
+ * ロック中はレジスター上の要素を空として扱い、呼び出し元の状態は stack_cache_saved_* に保存しておく。
+ */
+static __thread int32_t stack_cache_lock_count = 0;
+static __thread int32_t stack_cache_saved_bottom = 0;
+static __thread int32_t stack_cache_saved_len = 0;
+
+static const char* stack_cache_at(const int32_t index)
+{
+        return stack_cache_reg[(stack_cache_bottom + index) % STACK_CACHE_LEN];
+}
+
+/* レジスター上の最も古い要素を、メモリー上のスタックへ退避する
+ */
+static void stack_cache_spill(void)
+{
+        write_mem(stack_cache_at(0), "stack_head");
+        pA("stack_head++;");
+
+        stack_cache_bottom = (stack_cache_bottom + 1) % STACK_CACHE_LEN;
+        stack_cache_len--;
+
+        report_count.stack_spill++;
+}
+
+/* レジスター上の全ての要素を、古いものから順にメモリー上のスタックへ書き出す
  */
+void stack_cache_flush(void)
+{
+        while (stack_cache_len > 0)
+                stack_cache_spill();
+
+        stack_cache_bottom = 0;
+}
+
+/* 以降、stack_cache_unlock() までの間はレジスターを用いない
+ * ロック中に出力する命令は stack_cache** を読み書きしないので、レジスター上の要素はそのまま残る。
+ * （ロック中の命令は呼び出し元以外からも実行されるので、ここで書き出してはいけない）
+ */
+void stack_cache_lock(void)
+{
+        if (stack_cache_lock_count == 0) {
+                stack_cache_saved_bottom = stack_cache_bottom;
+                stack_cache_saved_len = stack_cache_len;
+
+                stack_cache_bottom = 0;
+                stack_cache_len = 0;
+        }
+
+        stack_cache_lock_count++;
+}
+
+void stack_cache_unlock(void)
+{
+        if (stack_cache_lock_count <= 0 || stack_cache_len != 0)
+                yyerror("system err: stack_cache_unlock()");
+
+        stack_cache_lock_count--;
+
+        if (stack_cache_lock_count == 0) {
+                stack_cache_bottom = stack_cache_saved_bottom;
+                stack_cache_len = stack_cache_saved_len;
+        }
+}
+
+/* レジスター上に新たな要素の場所を確保して、そのレジスター名を返す
+ * レジスターが足りない場合は、最も古い要素を退避してから確保する。
+ */
+static const char* stack_cache_push(void)
+{
+        if (stack_cache_len >= STACK_CACHE_LEN)
+                stack_cache_spill();
+
+        stack_cache_len++;
+
+        report_count.stack_cache_push++;
+
+        return stack_cache_at(stack_cache_len - 1);
+}
 
 /* 任意のレジスターの値をスタックにプッシュする。
  * 事前に stack_socket に値をセットせずに、ダイレクトで指定できるので、ソースが小さくなる
  */
 void push_stack(const char* regname_data)
 {
+        if (stack_cache_lock_count == 0) {
+                pA("%s = %s;", stack_cache_push(), regname_data);
+                return;
+        }
+
         write_mem(regname_data, "stack_head");
         pA("stack_head++;");
 
@@ -45,6 +158,12 @@ void push_stack(const char* regname_data)
  */
 void pop_stack(const char* regname_data)
 {
+        if (stack_cache_len > 0) {
+                stack_cache_len--;
+                pA("%s = %s;", regname_data, stack_cache_at(stack_cache_len));
+                return;
+        }
+
         pA("stack_head--;");
         read_mem(regname_data, "stack_head");
 
@@ -61,6 +180,11 @@ void pop_stack(const char* regname_data)
  */
 void push_stack_dummy(void)
 {
+        if (stack_cache_lock_count == 0) {
+                stack_cache_push();
+                return;
+        }
+
         pA("stack_head++;");
 }
 
@@ -70,6 +194,11 @@ void push_stack_dummy(void)
  */
 void pop_stack_dummy(void)
 {
+        if (stack_cache_len > 0) {
+                stack_cache_len--;
+                return;
+        }
+
         pA("stack_head--;");
 }
 
@@ -81,7 +210,15 @@ void init_stack(void)
         pB("SInt32 stack_socket:R03;");
         pB("SInt32 stack_tmp:R21;");
 
+        int32_t i;
+        for (i = 0; i < STACK_CACHE_LEN; i++)
+                pB("SInt32 %s:R%02X;", stack_cache_reg[i], STACK_CACHE_REG_BEGIN + i);
+
         pB("stack_head = %d;", STACK_BEGIN_ADDRESS);
+
+        stack_cache_bottom = 0;
+        stack_cache_len = 0;
+        stack_cache_lock_count = 0;
 }
 
 /* スタック関連の各種レジスターの値を、実行時に画面に印字する
@@ -5,10 +5,17 @@
 
 #define STACK_BEGIN_ADDRESS (MEM_SIZE - 0x200000)
 
+/* スタック上位の要素を置くレジスターの数と、その先頭のレジスター番号 (R23 - R2B) */
+#define STACK_CACHE_LEN         9
+#define STACK_CACHE_REG_BEGIN   0x23
+
 void push_stack(const char* regname_data);
 void pop_stack(const char* regname_data);
 void push_stack_dummy(void);
 void pop_stack_dummy(void);
+void stack_cache_flush(void);
+void stack_cache_lock(void);
+void stack_cache_unlock(void);
 void init_stack(void);
 void debug_stack(void);
 
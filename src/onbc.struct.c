@@ -20,14 +20,54 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include "onbc.iden.h"
 #include "onbc.var.h"
+#include "onbc.hash.h"
 #include "onbc.struct.h"
 
+/* 空の変数スペックのリストコンテナを生成する
+ */
+struct VarList* new_varlist(void)
+{
+        struct VarList* vl = malloc(sizeof(*vl));
+        if (vl == NULL)
+                yyerror("system err: new_varlist(), malloc()");
+
+        vl->var = NULL;
+        vl->varlist_len = 0;
+        vl->varlist_max = 0;
+
+        return vl;
+}
+
+/* 変数スペックのリストコンテナの末尾に var を追加する
+ */
+void varlist_push(struct VarList* vl, struct Var* var)
+{
+        if (vl->varlist_len >= vl->varlist_max) {
+                vl->varlist_max = (vl->varlist_max > 0) ? vl->varlist_max * 2 : 4;
+                vl->var = realloc(vl->var, sizeof(*(vl->var)) * vl->varlist_max);
+                if (vl->var == NULL)
+                        yyerror("system err: varlist_push(), realloc()");
+        }
+
+        vl->var[vl->varlist_len] = var;
+        vl->varlist_len++;
+}
+
+/* 変数スペックのリストコンテナを開放する（要素の変数スペック自体は開放しない）
+ */
+void delete_varlist(struct VarList* vl)
+{
+        free(vl->var);
+        free(vl);
+}
+
 /* 構造体メンバースペックのメモリー領域を確保し、値をセットし、アドレスを返す
  */
 struct Var*
 structmemberspec_new(const char* iden,
-                     int32_t* unit_len,
+                     const int32_t* unit_len,
                      const int32_t dim_len,
                      const int32_t indirect_len,
                      const int32_t type)
@@ -35,21 +75,31 @@ structmemberspec_new(const char* iden,
         if (dim_len >= VAR_DIM_MAX)
                 yyerror("syntax err: 配列の次元が高すぎます");
 
-        struct Var* member = new_var();
+        /* メンバーは構造体スペックと共に翻訳単位の終わりまで保持するので、アリーナからは確保しない */
+        struct Var* member = malloc(sizeof(*member));
+        if (member == NULL)
+                yyerror("system err: structmemberspec_new(), malloc()");
+
+        var_init(member);
 
-        strcpy(member->iden, iden);
+        member->iden = iden;
 
         member->dim_len = dim_len;
         member->indirect_len = indirect_len;
         member->type = type;
 
+        /* unit_len は構文解析の一時領域を指すので、共有せずに複製する */
+        int32_t* dim = var_new_dim(dim_len);
+
         int32_t unit_total_len = 1;
         int32_t i;
         for (i = 0; i < dim_len; i++) {
-                member->unit_len[i] = unit_len[i];
+                dim[i] = unit_len[i];
                 unit_total_len *= unit_len[i];
         }
 
+        member->unit_len = dim;
+
         member->unit_total_len = unit_total_len;
 
         return member;
@@ -98,14 +148,27 @@ void structspec_print(struct StructSpec* spec, const char* tab)
  */
 struct Var* structspec_search(struct StructSpec* spec, const char* iden)
 {
-        int i = spec->member_len;
-        while (i-->0) {
-                struct Var* p = spec->member_ptr[i];
-                if (strcmp(p->iden, iden) == 0)
-                        return p;
-        }
+        return hash_table_search(spec->member_table, iden);
+}
+
+/* 構造体スペックのメンバー配列を、少なくとも1要素追加できる大きさへ拡張する
+ */
+static void structspec_reserve_member(struct StructSpec* spec)
+{
+        if (spec->member_len < spec->member_max)
+                return;
+
+        const int32_t max = (spec->member_max > 0) ?
+                spec->member_max * 2 : STRUCTSPEC_MEMBER_INIT_LEN;
+
+        struct Var** ptr = realloc(spec->member_ptr, sizeof(*ptr) * max);
+        int32_t* offset = realloc(spec->member_offset, sizeof(*offset) * max);
+        if (ptr == NULL || offset == NULL)
+                yyerror("system err: structspec_reserve_member(), realloc()");
 
-        return NULL;
+        spec->member_ptr = ptr;
+        spec->member_offset = offset;
+        spec->member_max = max;
 }
 
 /* 構造体スペックに構造体メンバーの変数スペックを追加する
@@ -116,7 +179,10 @@ void structspec_add_member(struct StructSpec* spec, struct Var* member)
         if (structspec_search(spec, member->iden) != NULL)
                 yyerror("syntax err: 構造体のメンバー名が重複しています");
 
+        structspec_reserve_member(spec);
+
         spec->member_ptr[spec->member_len] = member;
+        hash_table_insert(spec->member_table, member->iden, member);
 
         /* 構造体中での、メンバーのオフセット位置をセット。
          * 新規追加する構造体メンバーのオフセット位置は、その時点での構造体サイズとなる。
@@ -143,9 +209,15 @@ struct StructSpec* structspec_new(void)
         if (spec == NULL)
                 yyerror("system err: structspec_new(), malloc()");
 
-        spec->iden[0] = '\0';
+        spec->iden = NULL;
         spec->struct_len = 0;
+        spec->member_ptr = NULL;
+        spec->member_offset = NULL;
         spec->member_len = 0;
+        spec->member_max = 0;
+
+        /* メンバー数の少ない構造体が大半なので、ハッシュテーブルは小さく作って必要に応じて拡張させる */
+        spec->member_table = new_iden_hash_table(STRUCTSPEC_MEMBER_INIT_LEN, NULL);
 
         return spec;
 }
@@ -154,10 +226,10 @@ struct StructSpec* structspec_new(void)
  */
 void structspec_set_iden(struct StructSpec* spec, const char* iden)
 {
-        if (spec->iden[0] != '\0')
+        if (spec->iden != NULL)
                 yyerror("system err: structspec_set_name(), spec->iden != NULL");
 
-        strcpy(spec->iden, iden);
+        spec->iden = iden;
 
 #ifdef DEBUG_STRUCTSPEC
         printf("structspec_set_iden(): iden[%s], struct_len[%d], member_len[%d]\n",
@@ -165,26 +237,60 @@ void structspec_set_iden(struct StructSpec* spec, const char* iden)
 #endif /* DEBUG_STRUCTSPEC */
 }
 
-/* 構造体スペックのポインターリスト
+/* 構造体スペックのポインターリスト（登録順。足りなくなれば倍に拡張する）
  */
-struct StructSpec* structspec_ptrlist[STRUCTSPEC_PTRLIST_LEN];
+static __thread struct StructSpec** structspec_ptrlist = NULL;
+static __thread int32_t structspec_ptrlist_max = 0;
 
 /* 現在の構造体スペックのポインターリストの先頭位置 */
-static int32_t cur_structspec_ptrlist_head = 0;
+static __thread int32_t cur_structspec_ptrlist_head = 0;
+
+/* 構造体名から構造体スペックを引くためのハッシュテーブル */
+static __thread struct HashTable* structspec_table = NULL;
+
+/* 構造体スペックのメンバーを含む全てのメモリー領域を開放する
+ */
+static void free_structspec(struct StructSpec* spec)
+{
+        int32_t i;
+        for (i = 0; i < spec->member_len; i++)
+                free_var(spec->member_ptr[i]);
+
+        free(spec->member_ptr);
+        free(spec->member_offset);
+        delete_hash_table(spec->member_table);
+        free(spec);
+}
+
+/* 構造体スペックのポインターリストに登録されてる構造体を、メンバーも含めて全て開放し、
+ * ポインターリストを空の状態に戻す。
+ * 翻訳単位ごとのコンパイル開始時に呼び出すこと。
+ */
+void init_structspec_ptrlist(void)
+{
+        int32_t i;
+        for (i = 0; i < cur_structspec_ptrlist_head; i++) {
+                free_structspec(structspec_ptrlist[i]);
+                structspec_ptrlist[i] = NULL;
+        }
+
+        cur_structspec_ptrlist_head = 0;
+
+        if (structspec_table == NULL)
+                structspec_table = new_iden_hash_table(0x40, NULL);
+        else
+                hash_table_clear(structspec_table);
+}
 
 /* 構造体スペックのポインターリストから、任意の名前の構造体スペックが登録されてるかを調べてアドレスを返す。
  * 無ければ NULL を返す。
  */
 struct StructSpec* structspec_ptrlist_search(const char* iden)
 {
-        int i = cur_structspec_ptrlist_head;
-        while (i-->0) {
-                struct StructSpec* spec = structspec_ptrlist[i];
-                if (strcmp(spec->iden, iden) == 0)
-                        return spec;
-        }
+        if (structspec_table == NULL)
+                return NULL;
 
-        return NULL;
+        return hash_table_search(structspec_table, iden);
 }
 
 /* 構造体スペックのポインターリストに登録されてる構造体の一覧表を表示する。
@@ -206,11 +312,28 @@ void structspec_ptrlist_print(void)
 void structspec_ptrlist_add(struct StructSpec* spec)
 {
         if (structspec_ptrlist_search(spec->iden) != NULL)
-                yyerror("syntax err: 構造体のメンバー名が重複しています");
+                yyerror("syntax err: 構造体名が重複しています");
+
+        if (structspec_table == NULL)
+                init_structspec_ptrlist();
+
+        if (cur_structspec_ptrlist_head >= structspec_ptrlist_max) {
+                const int32_t max = (structspec_ptrlist_max > 0) ?
+                        structspec_ptrlist_max * 2 : 0x40;
+
+                struct StructSpec** p = realloc(structspec_ptrlist, sizeof(*p) * max);
+                if (p == NULL)
+                        yyerror("system err: structspec_ptrlist_add(), realloc()");
+
+                structspec_ptrlist = p;
+                structspec_ptrlist_max = max;
+        }
 
         structspec_ptrlist[cur_structspec_ptrlist_head] = spec;
         cur_structspec_ptrlist_head++;
 
+        hash_table_insert(structspec_table, spec->iden, spec);
+
 #ifdef DEBUG_STRUCTSPEC_PTRLIST
         structspec_ptrlist_print();
 #endif /* DEBUG_STRUCTSPEC_PTRLIST */
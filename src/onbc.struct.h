@@ -1,39 +1,47 @@
 #include <stdint.h>
 #include "onbc.var.h"
+#include "onbc.hash.h"
 
 #ifndef __ONBC_STRUCT_H__
 #define __ONBC_STRUCT_H__
 
 /* 変数スペックのリストコンテナ
+ * var[] は varlist_push() で追加する。足りなくなれば倍に拡張する。
  */
-#define VARLIST_LEN 0x1000
 struct VarList {
-        struct Var* var[VARLIST_LEN];
+        struct Var** var;
         int32_t varlist_len;
+        int32_t varlist_max;
 };
 
+struct VarList* new_varlist(void);
+void varlist_push(struct VarList* vl, struct Var* var);
+void delete_varlist(struct VarList* vl);
+
 /* 構造体スペックリスト関連
  */
 
-/* 構造体が持てるメンバー数の上限 */
-#define STRUCTLIST_MEMBER_MAX 0x1000
+/* 構造体スペックのメンバー配列の初期確保数（足りなくなれば倍に拡張する） */
+#define STRUCTSPEC_MEMBER_INIT_LEN 4
 
 /* 構造体のスペック
  */
 struct StructSpec {
-        char iden[IDENLIST_STR_LEN];    /* 構造体の名前 */
+        const char* iden;               /* 構造体の名前（iden_intern() されたもの。無名の場合は NULL） */
         int32_t struct_len;             /* 構造体全体の長さ */
-        struct Var* member_ptr[STRUCTLIST_MEMBER_MAX];  /* 各メンバー変数スペックへのポインターのリスト */
-        int32_t member_offset[STRUCTLIST_MEMBER_MAX];   /* 各メンバー変数のオフセット */
+        struct Var** member_ptr;        /* 各メンバー変数スペックへのポインターのリスト */
+        int32_t* member_offset;         /* 各メンバー変数のオフセット */
         int32_t member_len;             /* メンバー変数の個数 */
+        int32_t member_max;             /* member_ptr[], member_offset[] の確保済み要素数 */
+        struct HashTable* member_table; /* メンバー名から変数スペックを引くためのハッシュテーブル */
 };
 
-#define STRUCTSPEC_PTRLIST_LEN 0x1000
-extern struct StructSpec* structspec_ptrlist[STRUCTSPEC_PTRLIST_LEN];
+/* 以下の iden を受け取る関数には、iden_intern() された文字列を渡すこと。（名前はアドレスで比較する）
+ */
 
 struct Var*
 structmemberspec_new(const char* iden,
-                     int32_t* unit_len,
+                     const int32_t* unit_len,
                      const int32_t dim_len,
                      const int32_t indirect_len,
                      const int32_t type);
@@ -44,6 +52,7 @@ void structspec_add_member(struct StructSpec* spec, struct Var* member);
 struct StructSpec* structspec_new(void);
 void structspec_set_iden(struct StructSpec* spec, const char* iden);
 struct StructSpec* structspec_ptrlist_search(const char* iden);
+void init_structspec_ptrlist(void);
 void structspec_ptrlist_print(void);
 void structspec_ptrlist_add(struct StructSpec* spec);
 
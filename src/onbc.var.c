@@ -21,26 +21,92 @@
 #include <string.h>
 #include <stdint.h>
 #include "onbc.print.h"
+#include "onbc.hash.h"
 #include "onbc.iden.h"
 #include "onbc.stack.h"
 #include "onbc.var.h"
+#include "onbc.report.h"
+#include "onbc.arena.h"
+
+/* 変数スペックを VARLIST_CHUNK_LEN 個ずつのチャンクに分けて保持するリスト
+ * 要素のアドレスはハッシュテーブルや呼出側から参照されるので、realloc() で移動させずに、
+ * 足りなくなればチャンクを追加していく。（チャンクは init_varlist() 後も再利用する）
+ */
+#define VARLIST_CHUNK_LEN 0x400
+struct VarChunkList {
+        struct Var** chunk;
+        int32_t chunk_len;
+};
+
+/* list の index 番目の要素のアドレスを返す。必要であればチャンクを追加する
+ */
+static struct Var* varchunk_at(struct VarChunkList* list, const int32_t index)
+{
+        const int32_t c = index / VARLIST_CHUNK_LEN;
+
+        while (c >= list->chunk_len) {
+                struct Var** chunk = realloc(list->chunk, sizeof(*chunk) * (list->chunk_len + 1));
+                if (chunk == NULL)
+                        yyerror("system err: varchunk_at(), realloc()");
+
+                chunk[list->chunk_len] = malloc(sizeof(**chunk) * VARLIST_CHUNK_LEN);
+                if (chunk[list->chunk_len] == NULL)
+                        yyerror("system err: varchunk_at(), malloc()");
+
+                list->chunk = chunk;
+                list->chunk_len++;
+        }
+
+        return list->chunk[c] + (index % VARLIST_CHUNK_LEN);
+}
+
+/* list の要素 var が何番目の要素かを返す。list の要素でなければ -1 を返す
+ * 新しい要素ほど後ろのチャンクに有るので、後ろのチャンクから調べる。
+ */
+static int32_t varchunk_index(struct VarChunkList* list, const struct Var* var)
+{
+        int32_t c = list->chunk_len;
+        while (c-->0) {
+                const struct Var* head = list->chunk[c];
+                if (var >= head && var < head + VARLIST_CHUNK_LEN)
+                        return c * VARLIST_CHUNK_LEN + (var - head);
+        }
+
+        return -1;
+}
 
 /* ローカル、グローバル、それぞれの変数スペックのリスト。
  * 全ての変数は、必ずこの何れかに含まれる。
  */
-#define VARLIST_LEN 0x1000
-static struct Var global_varlist[VARLIST_LEN];
-static struct Var local_varlist[VARLIST_LEN];
+static __thread struct VarChunkList global_varlist = {.chunk = NULL, .chunk_len = 0};
+static __thread struct VarChunkList local_varlist = {.chunk = NULL, .chunk_len = 0};
 
 /* {local,global}_varlist の現在の先頭から数えて最初の空位置
  */
-static int32_t global_varlist_head = 0;
-static int32_t local_varlist_head = 0;
+static __thread int32_t global_varlist_head = 0;
+static __thread int32_t local_varlist_head = 0;
+
+/* local_varlist のスコープ位置を記録しておくスタック（足りなくなれば倍に拡張する） */
+static __thread int32_t* local_varlist_scope = NULL;
+static __thread int32_t local_varlist_scope_head = 0;
+static __thread int32_t local_varlist_scope_max = 0;
+
+/* 変数名から {local,global}_varlist の要素を引くためのハッシュテーブル（値は struct Var*）
+ * 変数名は iden_intern() されたものなので、キーはアドレスで比較する。
+ *
+ * global_varlist_table は同名の変数が有れば後から追加されたものを指す。
+ * local_varlist_table は、現在見えている（最も内側のスコープの）変数を指す。
+ * 外側のスコープの同名の変数は、local_varlist_shadow[] に覚えておき、スコープを抜ける際に戻す。
+ */
+#define VARLIST_TABLE_BUCKET_LEN 0x400
+static __thread struct HashTable* global_varlist_table = NULL;
+static __thread struct HashTable* local_varlist_table = NULL;
 
-/* local_varlist のスコープ位置を記録しておくスタック */
-#define VARLIST_SCOPE_LEN VARLIST_LEN
-static int32_t local_varlist_scope[VARLIST_SCOPE_LEN] = {[0] = 0};
-static int32_t local_varlist_scope_head = 0;
+/* local_varlist の i 番目が追加された時点で、同名で見えていた変数（無ければ NULL）
+ * 足りなくなれば倍に拡張する。
+ */
+static __thread struct Var** local_varlist_shadow = NULL;
+static __thread int32_t local_varlist_shadow_max = 0;
 
 /* 次に呼び出される __local_varlist_add() によって変数を定義する際に、
  * その変数を新しいスコープの先頭とみなして、それの base_ptr に0をセットして定義するように予約する
@@ -52,7 +118,64 @@ static int32_t local_varlist_scope_head = 0;
  * local_varlist_add("b", unit, len, 0, TYPE_INT); // 以降の b, c は普通に宣言していけばいい
  * local_varlist_add("c", unit, len, 0, TYPE_INT);
  */
-int32_t next_local_varlist_add_set_new_scope = 0;
+__thread int32_t next_local_varlist_add_set_new_scope = 0;
+
+/* register 変数に割り当てるレジスター
+ * regvar_head は使用中のレジスターの数。ローカル変数と同じく、スコープを抜ける時に後から割り当てたものから開放する。
+ */
+static const char* const regvar_reg[REGVAR_LEN] = {
+        "regvar00", "regvar01", "regvar02", "regvar03",
+};
+static __thread int32_t regvar_head = 0;
+
+/* var_new_dim() で確保した配列次元のリスト
+ * 次元の配列は複数の Var から共有されるので個別には開放せず、翻訳単位ごとにまとめて開放する。
+ */
+static __thread int32_t** dim_pool = NULL;
+static __thread int32_t dim_pool_len = 0;
+static __thread int32_t dim_pool_max = 0;
+
+static void free_dim_pool(void)
+{
+        int32_t i;
+        for (i = 0; i < dim_pool_len; i++)
+                free(dim_pool[i]);
+
+        dim_pool_len = 0;
+}
+
+/* {local,global}_varlist を空の状態に戻す
+ * 翻訳単位ごとのコンパイル開始時に呼び出すこと。
+ */
+void init_varlist(void)
+{
+        free_dim_pool();
+
+        global_varlist_head = 0;
+        local_varlist_head = 0;
+
+        if (global_varlist_table == NULL) {
+                global_varlist_table = new_iden_hash_table(VARLIST_TABLE_BUCKET_LEN, NULL);
+                local_varlist_table = new_iden_hash_table(VARLIST_TABLE_BUCKET_LEN, NULL);
+        } else {
+                hash_table_clear(global_varlist_table);
+                hash_table_clear(local_varlist_table);
+        }
+
+        if (local_varlist_scope == NULL) {
+                local_varlist_scope_max = 0x40;
+                local_varlist_scope = malloc(sizeof(*local_varlist_scope) * local_varlist_scope_max);
+                if (local_varlist_scope == NULL)
+                        yyerror("system err: init_varlist(), malloc()");
+        }
+
+        local_varlist_scope[0] = 0;
+        local_varlist_scope_head = 0;
+
+        next_local_varlist_add_set_new_scope = 0;
+
+        regvar_head = 0;
+}
 
 /* Varの内容を印字する
  * 主にデバッグ用
@@ -68,7 +191,7 @@ void var_print(struct Var* var)
                var->iden, var->is_lvalue, var->base_ptr, var->unit_total_len);
 
         int32_t i;
-        for (i = 0; i < var->dim_len; i++) {
+        for (i = 0; var->unit_len != NULL && i < var->dim_len; i++) {
                 printf("[%d]", var->unit_len[i]);
         }
 
@@ -86,7 +209,7 @@ void var_print(struct Var* var)
 struct Var* var_set_param(struct Var* var,
                           const char* iden,
                           const int32_t base_ptr,
-                          int32_t* unit_len,
+                          const int32_t* unit_len,
                           const int32_t dim_len,
                           const int32_t unit_total_len,
                           const int32_t indirect_len,
@@ -94,43 +217,104 @@ struct Var* var_set_param(struct Var* var,
                           const int32_t is_lvalue,
                           void* const_variable)
 {
-        strcpy(var->iden, iden);
+        var->iden = iden;
         var->base_ptr = base_ptr;
-
-        int32_t i;
-        for (i = 0; i < dim_len; i++)
-                var->unit_len[i] = unit_len[i];
-
+        var->unit_len = unit_len;
         var->dim_len = dim_len;
         var->unit_total_len = unit_total_len;
         var->indirect_len = indirect_len;
         var->type = type;
         var->is_lvalue = is_lvalue;
         var->const_variable = const_variable;
+        var->regvar = -1;
 
         return var;
 }
 
-/* 空のVarインスタンスを生成する */
-struct Var* new_var(void)
+/* var を空の状態にして返す */
+struct Var* var_init(struct Var* var)
 {
-        struct Var* var = malloc(sizeof(*var));
-        if (var == NULL)
-                yyerror("system err: new_var(), malloc()");
-
-        var->iden[0] = '\0';
+        var->iden = "";
         var->base_ptr = 0;
         var->unit_total_len = 0;
+        var->unit_len = NULL;
         var->dim_len = 0;
         var->indirect_len = 0;
         var->type = 0;
         var->is_lvalue = 0;
         var->const_variable = NULL;
+        var->regvar = -1;
 
         return var;
 }
 
-/* Varインスタンスを開放する */
+/* 空のVarインスタンスを生成する
+ * アリーナから確保するので、external_declaration の翻訳後の arena_reset() でまとめて開放される。
+ * （それより長く保持する必要が有る場合は、malloc() した領域を var_init() して用いること）
+ */
+struct Var* new_var(void)
+{
+        struct Var* var = var_init(arena_alloc(sizeof(*var)));
+
+        report_count.var_new++;
+
+        return var;
+}
+
+/* dim_len 個の要素を持つ、配列次元の配列を新たに確保する
+ * 内容をセットした後は書き換えずに、Var.unit_len として共有すること。
+ */
+int32_t* var_new_dim(const int32_t dim_len)
+{
+        if (dim_pool_len >= dim_pool_max) {
+                dim_pool_max = (dim_pool_max == 0) ? 0x100 : dim_pool_max * 2;
+                dim_pool = realloc(dim_pool, sizeof(*dim_pool) * dim_pool_max);
+                if (dim_pool == NULL)
+                        yyerror("system err: var_new_dim(), realloc()");
+        }
+
+        int32_t* dim = malloc(sizeof(*dim) * (dim_len > 0 ? dim_len : 1));
+        if (dim == NULL)
+                yyerror("system err: var_new_dim(), malloc()");
+
+        dim_pool[dim_pool_len++] = dim;
+
+        return dim;
+}
+
+/* var の配列次元の末尾に、長さ unit_len の次元を追加する
+ */
+void var_push_dim(struct Var* var, const int32_t unit_len)
+{
+        if (var->dim_len + 1 >= VAR_DIM_MAX)
+                yyerror("syntax err: 配列の次元が高すぎます");
+
+        int32_t* dim = var_new_dim(var->dim_len + 1);
+
+        int32_t i;
+        for (i = 0; i < var->dim_len; i++)
+                dim[i] = var->unit_len[i];
+
+        dim[var->dim_len] = unit_len;
+
+        var->unit_len = dim;
+        var->dim_len++;
+}
+
+/* src の内容を dst へコピーし、dst を返す
+ * Var のコピーは全てこの関数を経由させる。（--time-report でコピー回数を集計するため）
+ * iden と unit_len[] はポインターのみをコピーし、dst と src とで共有する。
+ */
+struct Var* var_copy(struct Var* dst, struct Var* src)
+{
+        *dst = *src;
+
+        report_count.var_copy++;
+
+        return dst;
+}
+
+/* malloc() したVarインスタンスを開放する（new_var() で生成したものには用いないこと） */
 void free_var(struct Var* var)
 {
         if (var->const_variable != NULL)
@@ -139,10 +323,90 @@ void free_var(struct Var* var)
         free(var);
 }
 
+/* 変数スペックが即値（スタックにもメモリーにも置かれていない定数）である場合は真を返す。
+ * 即値の値は const_variable に保持しており、読み込む時点でレジスターへ直接セットする。
+ */
+int32_t var_is_immediate(struct Var* var)
+{
+        if ((!var->is_lvalue) && (var->type & TYPE_LITERAL) && (var->const_variable != NULL))
+                return 1;
+
+        return 0;
+}
+
+/* 変数スペックが、レジスターに割り当てた register 変数そのもの（左辺値）である場合は真を返す。
+ * register 変数の値の読み書きは、メモリーではなく var_register_name() のレジスターに対して行う。
+ */
+int32_t var_is_register(struct Var* var)
+{
+        if (var->is_lvalue && (var->base_ptr != -1) && (var->regvar >= 0))
+                return 1;
+
+        return 0;
+}
+
+/* register 変数に割り当てたレジスター名を返す
+ */
+const char* var_register_name(struct Var* var)
+{
+        if (var->regvar < 0 || var->regvar >= REGVAR_LEN)
+                yyerror("system err: var_register_name()");
+
+        return regvar_reg[var->regvar];
+}
+
+/* ユーザー関数の呼び出し前に、使用中の register 変数のレジスターをメモリー上のスタックへ退避する
+ * 呼び出し先も同じレジスターを自身の register 変数に用いるので、呼び出し元で保存する。
+ */
+void var_register_save(void)
+{
+        stack_cache_lock();
+
+        int32_t i;
+        for (i = 0; i < regvar_head; i++)
+                push_stack(regvar_reg[i]);
+
+        stack_cache_unlock();
+}
+
+/* ユーザー関数から戻った後に、var_register_save() で退避したレジスターを戻す
+ * スタックは [退避したレジスター][戻り値] の状態なので、戻り値を一旦 fixA へ取り出してから積み直す。
+ */
+void var_register_restore(void)
+{
+        if (regvar_head == 0)
+                return;
+
+        stack_cache_lock();
+
+        pop_stack("fixA");
+
+        int32_t i;
+        for (i = regvar_head - 1; i >= 0; i--)
+                pop_stack(regvar_reg[i]);
+
+        stack_cache_unlock();
+
+        push_stack("fixA");
+}
+
+/* register 変数用レジスターの宣言
+ */
+void init_regvar(void)
+{
+        int32_t i;
+        for (i = 0; i < REGVAR_LEN; i++)
+                pB("SInt32 %s:R%02X;", regvar_reg[i], REGVAR_REG_BEGIN + i);
+}
+
 /* A dummy of read value from variable
+ * 即値はスタックへ積まれていないので、何もしない。
  */
 void var_read_value_dummy(struct Var* var)
 {
+        if (var_is_immediate(var))
+                return;
+
         if (!(var->is_lvalue && (var->base_ptr != -1)))
                 pop_stack_dummy();
 }
@@ -158,9 +422,17 @@ var_read_array_address(struct Var* var, const char* register_name)
                 var->unit_total_len /= var->unit_len[0];
                 pA("%s *= %d;", register_name, var->unit_total_len);
 
+                /* unit_len[] は他の Var と共有しているので、書き換えずに複製を作る (copy-on-write)
+                 * 添字を解決した後の次元は式の評価中にしか用いないので、複製はアリーナに置く。
+                 */
+                int32_t* dim = arena_alloc(sizeof(*dim) * var->dim_len);
+
                 int32_t i;
                 for (i = 0; i < var->dim_len - 1; i++)
-                        var->unit_len[i] = var->unit_len[i + 1];
+                        dim[i] = var->unit_len[i + 1];
+
+                dim[var->dim_len - 1] = var->unit_len[var->dim_len - 1];
+                var->unit_len = dim;
         }
 
         if (var->is_lvalue) {
@@ -197,6 +469,9 @@ var_read_array_address(struct Var* var, const char* register_name)
 static struct Var*
 var_read_scalar_address(struct Var* var, const char* register_name)
 {
+        if (var_is_register(var))
+                yyerror("syntax err: register 変数のアドレスは得られません");
+
         if (var->is_lvalue) {
                 if (var->base_ptr != -1) {
                         int32_t bp = var->base_ptr;
@@ -251,6 +526,8 @@ var_pre_read_scalar_value(struct Var* var, const char* register_name)
 {
         if (var->is_lvalue)
                 var = var_read_scalar_address(var, register_name);
+        else if (var_is_immediate(var))
+                pA("%s = %d;", register_name, *((int*)(var->const_variable)));
         else
                 pop_stack(register_name);
 
@@ -287,6 +564,13 @@ var_realize_read_array_value(struct Var* var, const char* register_name)
 static struct Var*
 var_realize_read_scalar_value(struct Var* var, const char* register_name)
 {
+        if (var_is_register(var)) {
+                pA("%s = %s;", register_name, var_register_name(var));
+                var->is_lvalue = 0;
+                var->regvar = -1;
+                return var;
+        }
+
         var = var_pre_read_value(var, register_name);
         if (var->is_lvalue) {
                 read_mem(register_name, register_name);
@@ -320,6 +604,7 @@ var_indirect_pre_read_value(struct Var* var, const char* register_name)
 
         var->indirect_len--;
         var->is_lvalue = 1;
+        var->regvar = -1; /* 間接参照先はメモリー上の値 */
 
         return var;
 }
@@ -333,73 +618,72 @@ void local_varlist_scope_push(void)
 {
         local_varlist_scope_head++;
 
-        if (local_varlist_scope_head >= VARLIST_SCOPE_LEN)
-                yyerror("system err: local_varlist_scope_push()");
+        if (local_varlist_scope_head >= local_varlist_scope_max) {
+                local_varlist_scope_max *= 2;
+                local_varlist_scope = realloc(local_varlist_scope,
+                                              sizeof(*local_varlist_scope) * local_varlist_scope_max);
+                if (local_varlist_scope == NULL)
+                        yyerror("system err: local_varlist_scope_push(), realloc()");
+        }
 
         local_varlist_scope[local_varlist_scope_head] = local_varlist_head;
 }
 
 /* local_varlist_scopeからポップし、local_varlist_headへセットする
+ * スコープ内で宣言された変数を local_varlist_table から外し、それらが隠していた外側の変数を戻す。
  */
 void local_varlist_scope_pop(void)
 {
         if (local_varlist_scope_head < 0)
                 yyerror("system err: local_varlist_scope_pop()");
 
-        local_varlist_head = local_varlist_scope[local_varlist_scope_head];
-        local_varlist_scope_head--;
-}
+        const int32_t head = local_varlist_scope[local_varlist_scope_head];
+        while (local_varlist_head > head) {
+                local_varlist_head--;
 
-/* グローバル変数リストに既に同名が登録されているかを、グローバル変数の範囲内で確認する。
- */
-struct Var* global_varlist_search(const char* iden)
-{
-        int32_t i = global_varlist_head;
-        while (i-->0) {
-                if (strcmp(iden, global_varlist[i].iden) == 0)
-                        return global_varlist + i;
+                const struct Var* var = varchunk_at(&local_varlist, local_varlist_head);
+                if (var->regvar >= 0)
+                        regvar_head = var->regvar;
+
+                const char* iden = var->iden;
+                struct Var* shadow = local_varlist_shadow[local_varlist_head];
+                if (shadow != NULL)
+                        hash_table_insert(local_varlist_table, iden, shadow);
+                else
+                        hash_table_remove(local_varlist_table, iden);
         }
 
-        return NULL;
+        local_varlist_head = head;
+        local_varlist_scope_head--;
 }
 
-/* ローカル変数リストに既に同名が登録されているかを検索する場合の共通ルーチン。
- * 検索順序は top -> bottom の方向となる。
+/* グローバル変数リストに既に同名が登録されているかを、グローバル変数の範囲内で確認する。
  */
-static struct Var* local_varlist_search_common(const char* iden,
-                                               const int32_t top,
-                                               const int32_t bottom)
+struct Var* global_varlist_search(const char* iden)
 {
-        struct Var* p = local_varlist + top;
-        int i;
-        for (i = top; i >= bottom; i--) {
-                if (strcmp(iden, p->iden) == 0)
-                        return p;
-
-                p--;
-        }
-
-        return NULL;
+        return hash_table_search(global_varlist_table, iden);
 }
 
 /* ローカル変数リストに既に同名が登録されているかを、現在のローカル変数スコープ限定で確認する。
+ * 見えている変数が現在のスコープの範囲 (local_varlist_scope[] 以降) に有る場合のみ返す。
  */
 static struct Var* local_varlist_search_scope(const char* iden)
 {
-        const int32_t top = local_varlist_head - 1;
-        const int32_t bottom = local_varlist_scope[local_varlist_scope_head];
+        struct Var* var = hash_table_search(local_varlist_table, iden);
+        if (var == NULL)
+                return NULL;
+
+        if (varchunk_index(&local_varlist, var) < local_varlist_scope[local_varlist_scope_head])
+                return NULL;
 
-        return local_varlist_search_common(iden, top, bottom);
+        return var;
 }
 
 /* ローカル変数リストに既に同名が登録されているかを、現在のローカル変数スコープ以下の全スコープから確認する。
  */
 static struct Var* local_varlist_search_all(const char* iden)
 {
-        const int32_t top = local_varlist_head - 1;
-        const int32_t bottom = 0;
-
-        return local_varlist_search_common(iden, top, bottom);
+        return hash_table_search(local_varlist_table, iden);
 }
 
 /* 変数リストに既に同名が登録されているかを、{local,global}_varlist_head以下から確認する。
@@ -455,7 +739,7 @@ int32_t var_get_type_to_size(struct Var* var)
  * and each array index (unit_len[]).
  */
 static int32_t
-get_unit_total_len(int32_t* unit_len, const int32_t dim_len)
+get_unit_total_len(const int32_t* unit_len, const int32_t dim_len)
 {
         int32_t unit_total_len = 1;
         int32_t i;
@@ -474,7 +758,7 @@ get_unit_total_len(int32_t* unit_len, const int32_t dim_len)
  */
 static struct Var*
 global_varlist_add(const char* iden,
-                   int32_t* unit_len,
+                   const int32_t* unit_len,
                    const int32_t dim_len,
                    const int32_t indirect_len,
                    const int32_t type)
@@ -482,11 +766,11 @@ global_varlist_add(const char* iden,
         if (next_local_varlist_add_set_new_scope)
                 yyerror("system err: global_varlist_add()");
 
-        struct Var* cur = global_varlist + global_varlist_head;
-        struct Var* prev = global_varlist + global_varlist_head - 1;
+        struct Var* cur = varchunk_at(&global_varlist, global_varlist_head);
 
         int32_t base_ptr = 0x00001000;
         if (global_varlist_head >= 1) {
+                const struct Var* prev = varchunk_at(&global_varlist, global_varlist_head - 1);
                 const int32_t prev_type_size = get_type_to_size(prev->type, prev->indirect_len);
                 const int32_t prev_total_size = prev->unit_total_len * prev_type_size;
 
@@ -498,21 +782,24 @@ global_varlist_add(const char* iden,
         const int32_t unit_total_len = get_unit_total_len(unit_len, dim_len);
         const int32_t is_lvalue = 1;
 
-        return var_set_param(cur, iden, base_ptr, unit_len, dim_len, unit_total_len,
-                             indirect_len, type, is_lvalue, NULL);
+        var_set_param(cur, iden, base_ptr, unit_len, dim_len, unit_total_len,
+                      indirect_len, type, is_lvalue, NULL);
+
+        hash_table_insert(global_varlist_table, cur->iden, cur);
+
+        return cur;
 }
 
 /* This adds a variable to a list of local variable newly.
  */
 static struct Var*
 local_varlist_add(const char* iden,
-                  int32_t* unit_len,
+                  const int32_t* unit_len,
                   const int32_t dim_len,
                   const int32_t indirect_len,
                   const int32_t type)
 {
-        struct Var* cur = local_varlist + local_varlist_head;
-        struct Var* prev = local_varlist + local_varlist_head - 1;
+        struct Var* cur = varchunk_at(&local_varlist, local_varlist_head);
 
         int32_t base_ptr = 0;
         if (next_local_varlist_add_set_new_scope) {
@@ -520,6 +807,7 @@ local_varlist_add(const char* iden,
                 next_local_varlist_add_set_new_scope = 0;
         } else {
                 if (local_varlist_head >= 1) {
+                        const struct Var* prev = varchunk_at(&local_varlist, local_varlist_head - 1);
                         const int32_t prev_type_size = get_type_to_size(prev->type, prev->indirect_len);
                         const int32_t prev_total_size = prev->unit_total_len * prev_type_size;
 
@@ -527,13 +815,27 @@ local_varlist_add(const char* iden,
                 }
         }
 
+        if (local_varlist_head >= local_varlist_shadow_max) {
+                local_varlist_shadow_max = (local_varlist_shadow_max > 0) ? local_varlist_shadow_max * 2 : 0x100;
+                local_varlist_shadow = realloc(local_varlist_shadow,
+                                               sizeof(*local_varlist_shadow) * local_varlist_shadow_max);
+                if (local_varlist_shadow == NULL)
+                        yyerror("system err: local_varlist_add(), realloc()");
+        }
+
+        local_varlist_shadow[local_varlist_head] = hash_table_search(local_varlist_table, iden);
+
         local_varlist_head++;
 
         const int32_t unit_total_len = get_unit_total_len(unit_len, dim_len);
         const int32_t is_lvalue = 1;
 
-        return var_set_param(cur, iden, base_ptr, unit_len, dim_len, unit_total_len,
-                             indirect_len, type, is_lvalue, NULL);
+        var_set_param(cur, iden, base_ptr, unit_len, dim_len, unit_total_len,
+                      indirect_len, type, is_lvalue, NULL);
+
+        hash_table_insert(local_varlist_table, cur->iden, cur);
+
+        return cur;
 }
 
 /* This add a variable to a list of variables newly.
@@ -549,7 +851,7 @@ local_varlist_add(const char* iden,
  */
 static struct Var*
 varlist_add(const char* iden,
-            int32_t* unit_len,
+            const int32_t* unit_len,
             const int32_t dim_len,
             const int32_t indirect_len,
             const int32_t type)
@@ -586,6 +888,7 @@ static struct Var* var_initializer_local_alloc(struct Var* var)
         const int32_t type_size = get_type_to_size(var->type, var->indirect_len);
         const int32_t total_size = var->unit_total_len * type_size;
 
+        stack_cache_flush();
         pA("stack_head = stack_frame + %d;", var->base_ptr + total_size);
 
         return var;
@@ -622,6 +925,14 @@ static struct Var* var_initializer_local_new(struct Var* var, const int32_t type
         else
                 ret = var_initializer_local_alloc(ret);
 
+        /* register 指定されたスカラーのローカル変数は、空きが有ればレジスターに割り当てる。
+         * （メモリー上の領域も確保しておくが、値の読み書きには用いない。
+         *   関数引数は呼び出し元がメモリー上のスタックへ積むので、割り当てない）
+         */
+        if ((type & TYPE_REGISTER) && !(type & (TYPE_WIND | TYPE_STRUCT)) &&
+            (ret->dim_len == 0) && (regvar_head < REGVAR_LEN))
+                ret->regvar = regvar_head++;
+
         return ret;
 }
 
@@ -40,13 +40,17 @@
 #define TYPE_FUNCTION   (1 << 30)
 
 /* コンパイル時点に確定する変数スペック
+ *
+ * Var は頻繁にコピーされるので、可変長の情報は持たずにポインターで参照する。
+ * iden は iden_intern() された文字列、unit_len は var_new_dim() で作られた不変の配列であり、
+ * どちらもコピー先と共有される。（書き換える場合は新たに作り直すこと）
  */
 #define VAR_DIM_MAX 0x100
 struct Var {
-        char iden[IDENLIST_STR_LEN];
+        const char* iden;       /* 変数名 */
         int32_t base_ptr;       /* この変数が値の記録に用いる記憶域の先頭アドレス */
         int32_t unit_total_len; /* 配列変数全体の長さ */
-        int32_t unit_len[VAR_DIM_MAX];  /* 各配列次元の長さ */
+        const int32_t* unit_len;        /* 各配列次元の長さ */
         int32_t dim_len;        /* 配列の次元数 */
         int32_t indirect_len;   /* 間接参照の深さ。直接参照(非ポインター型)ならば0 */
         int32_t type;           /* specifier | qualifier | storage_class による変数属性 */
@@ -54,28 +58,47 @@ struct Var {
                                  * 即値で得る場合(右辺値)は0。
                                  */
         void* const_variable;   /* 変数が定数の場合の値 */
+        int32_t regvar;         /* register 変数として割り当てたレジスターの番号。割り当てていなければ -1 */
 };
 
-extern int32_t next_local_varlist_add_set_new_scope;
+/* register 変数に割り当てるレジスターの数と、その先頭のレジスター番号 (R2C - R2F) */
+#define REGVAR_LEN              4
+#define REGVAR_REG_BEGIN        0x2C
+
+extern __thread int32_t next_local_varlist_add_set_new_scope;
+
+/* 以下の iden を受け取る関数には、iden_intern() された文字列を渡すこと。（変数名はアドレスで比較する）
+ */
 
 void var_print(struct Var* var);
 struct Var* var_set_param(struct Var* var,
                           const char* iden,
                           const int32_t base_ptr,
-                          int32_t* unit_len,
+                          const int32_t* unit_len,
                           const int32_t dim_len,
                           const int32_t unit_total_len,
                           const int32_t indirect_len,
                           const int32_t type,
                           const int32_t is_lvalue,
                           void* const_valiable);
+struct Var* var_init(struct Var* var);
 struct Var* new_var(void);
+int32_t* var_new_dim(const int32_t dim_len);
+void var_push_dim(struct Var* var, const int32_t unit_len);
+struct Var* var_copy(struct Var* dst, struct Var* src);
 void free_var(struct Var* var);
+int32_t var_is_immediate(struct Var* var);
+int32_t var_is_register(struct Var* var);
+const char* var_register_name(struct Var* var);
+void var_register_save(void);
+void var_register_restore(void);
+void init_regvar(void);
 void var_read_value_dummy(struct Var* var);
 struct Var* var_read_address(struct Var* var, const char* register_name);
 struct Var* var_pre_read_value(struct Var* var, const char* register_name);
 struct Var* var_realize_read_value(struct Var* var, const char* register_name);
 struct Var* var_indirect_pre_read_value(struct Var* var, const char* register_name);
+void init_varlist(void);
 void local_varlist_scope_push(void);
 void local_varlist_scope_pop(void);
 int32_t var_get_type_to_size(struct Var* var);
@@ -47,11 +47,10 @@ test05()
         puts("var_initializer_new()で、指定したスペックのグローバル変数が作成されるかのテスト");
 
         struct Var* var = new_var();
-        strcpy(var->iden, "global_float_x");
-        var->unit_len[0] = 10;
-        var->unit_len[1] = 20;
-        var->unit_len[2] = 30;
-        var->dim_len = 3;
+        var->iden = iden_intern("global_float_x");
+        var_push_dim(var, 10);
+        var_push_dim(var, 20);
+        var_push_dim(var, 30);
         var->indirect_len = 100;
         var->type = TYPE_FLOAT;
 
@@ -77,11 +76,10 @@ test06()
         puts("var_initializer_new()で、指定したスペックのローカル変数が作成されるかのテスト");
 
         struct Var* var = new_var();
-        strcpy(var->iden, "local_int_x");
-        var->unit_len[0] = 10;
-        var->unit_len[1] = 20;
-        var->unit_len[2] = 30;
-        var->dim_len = 3;
+        var->iden = iden_intern("local_int_x");
+        var_push_dim(var, 10);
+        var_push_dim(var, 20);
+        var_push_dim(var, 30);
         var->indirect_len = 100;
         var->type = TYPE_INT;
 
@@ -102,14 +100,15 @@ test06()
 
 }
 
-FILE* yyaskA;
-FILE* yyaskB;
-int32_t linenumber = 0;
-char filepath[] = "/dev/null";
+__thread FILE* yyaskA;
+__thread FILE* yyaskB;
+__thread int32_t linenumber = 0;
+__thread const char* filepath = "/dev/null";
 
 int main(int argc, char** argv)
 {
         yyaskA = fopen("test.onbc.var.ask", "wt");
+        init_varlist();
 
         test01();
         test02();